@@ -54,6 +54,9 @@ export class MarketTradesComponent implements OnInit {
       { width: 50, field: 'quantity', headerName: 'qty', cellClass: (params) => {
           return (params.data.side === 'Ask') ? "sell" : "buy";
       }, cellRendererFramework: BaseCurrencyCellComponent},
+      { width: 40, field: 'count', headerName: 'prints', cellClass: (params) => {
+          return (params.data.side === 'Ask') ? "sell" : "buy";
+      }},
       { width: 40, field: 'side', headerName: 'side' , cellClass: (params) => {
         if (params.value === 'Bid') return 'buy';
         else if (params.value === 'Ask') return "sell";
@@ -61,19 +64,25 @@ export class MarketTradesComponent implements OnInit {
     ];
   }
 
-  private addRowData = (trade: Models.MarketTrade) => {
+  private addRowData = (trade: Models.MarketTrade | Models.MarketTakersBucket) => {
     if (!this.gridOptions.api || this.product.base == null) return;
-    if (trade != null)
-      this.gridOptions.api.applyTransaction({add:[{
-        price: trade.price,
-        quantity: trade.quantity,
-        time: trade.time,
-        recent: true,
-        side: Models.Side[trade.side],
-        quoteSymbol: this.product.quote,
-        productFixedPrice: this.product.tickPrice,
-        productFixedSize: this.product.tickSize
-      }]});
+    if (trade == null) return;
+    var rows = [];
+    if ('bids' in trade) {
+      if (trade.bids) rows.push({price: trade.bidPrice, quantity: trade.bidSize, count: trade.bids, side: Models.Side.Bid});
+      if (trade.asks) rows.push({price: trade.askPrice, quantity: trade.askSize, count: trade.asks, side: Models.Side.Ask});
+    } else rows.push({price: trade.price, quantity: trade.quantity, count: 1, side: trade.side});
+    this.gridOptions.api.applyTransaction({add:rows.map(row => ({
+      price: row.price,
+      quantity: row.quantity,
+      count: row.count,
+      time: trade.time,
+      recent: true,
+      side: Models.Side[row.side],
+      quoteSymbol: this.product.quote,
+      productFixedPrice: this.product.tickPrice,
+      productFixedSize: this.product.tickSize
+    }))});
 
     this.gridOptions.api.forEachNode((node: RowNode) => {
       if (Math.abs(trade.time - node.data.time) > 3600000)
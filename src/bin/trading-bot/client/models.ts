@@ -56,6 +56,16 @@ export class MarketTrade {
                 public side: Side) {}
 }
 
+export class MarketTakersBucket {
+    constructor(public time: number,
+                public bidSize: number,
+                public bidPrice: number,
+                public bids: number,
+                public askSize: number,
+                public askPrice: number,
+                public asks: number) {}
+}
+
 export enum Connectivity { Disconnected, Connected }
 export enum Side { Bid, Ask, Unknown }
 export enum OrderType { Limit, Market }
@@ -244,7 +254,7 @@ export class ProductAdvertisement {
 }
 
 export class ApplicationState {
-    constructor(public addr: string, public freq: number, public theme: number, public memory: number, public dbsize: number) { }
+    constructor(public addr: string, public freq: number, public theme: number, public memory: number, public dbsize: number, public dblag: number, public dbqueue: number, public dbdrop: number, public quota: number, public throttled: number) { }
 }
 
 export class TradeSafety {
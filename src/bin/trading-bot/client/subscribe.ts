@@ -9,7 +9,10 @@ export class KSocket {
   public ws;
   constructor() {
     socket = this;
-    this.ws = new WebSocket(location.origin.replace('http', 'ws'));
+    this.ws = location.hash.indexOf('cbor') > -1
+      ? new WebSocket(location.origin.replace('http', 'ws'), ['cbor'])
+      : new WebSocket(location.origin.replace('http', 'ws'));
+    this.ws.binaryType = 'arraybuffer';
     for (const ev in events) events[ev].forEach(cb => this.ws.addEventListener(ev, cb));
     this.ws.addEventListener('close', () => {
       setTimeout(() => { new KSocket(); }, 5000);
@@ -23,6 +26,64 @@ export class KSocket {
 }
 
 
+function cbor(view: DataView): any {
+  var pos = 0;
+  const length = (info: number): number => {
+    var len: number = info;
+    if      (info == 24) { len = view.getUint8(pos);  pos += 1; }
+    else if (info == 25) { len = view.getUint16(pos); pos += 2; }
+    else if (info == 26) { len = view.getUint32(pos); pos += 4; }
+    else if (info == 27) { len = view.getUint32(pos) * 4294967296 + view.getUint32(pos + 4); pos += 8; }
+    return len;
+  };
+  const bytes = (len: number): Uint8Array => {
+    const data = new Uint8Array(view.buffer, view.byteOffset + pos, len);
+    pos += len;
+    return data;
+  };
+  const item = (): any => {
+    const head = view.getUint8(pos++);
+    const info = head & 0x1F;
+    switch (head >> 5) {
+      case 0: return length(info);
+      case 1: return -1 - length(info);
+      case 2: return bytes(length(info));
+      case 3: return new TextDecoder().decode(bytes(length(info)));
+      case 4: {
+        const data = [];
+        for (var i = length(info); i > 0; i--) data.push(item());
+        return data;
+      }
+      case 5: {
+        const data = {};
+        for (var i = length(info); i > 0; i--) {
+          const key = item();
+          data[key] = item();
+        }
+        return data;
+      }
+      case 6: length(info); return item();
+    }
+    var value: number;
+    if      (info == 20) return false;
+    else if (info == 21) return true;
+    else if (info == 22 || info == 23) return null;
+    else if (info == 25) {
+      const half = view.getUint16(pos);
+      const exp = (half >> 10) & 0x1F, mant = half & 0x3FF;
+      value = exp == 0 ? mant * Math.pow(2, -24)
+            : exp != 31 ? (mant + 1024) * Math.pow(2, exp - 25)
+            : (mant ? NaN : Infinity);
+      if (half & 0x8000) value = -value;
+      pos += 2;
+    }
+    else if (info == 26) { value = view.getFloat32(pos); pos += 4; }
+    else if (info == 27) { value = view.getFloat64(pos); pos += 8; }
+    return value;
+  };
+  return item();
+}
+
 export interface ISubscribe<T> {
   registerSubscriber: (incrementalHandler: (msg: T) => void) => ISubscribe<T>;
   registerConnectHandler: (handler: () => void) => ISubscribe<T>;
@@ -44,8 +105,13 @@ export class Subscriber<T> extends Observable<T> implements ISubscribe<T> {
       socket.setEventListener('open', this.onConnect);
       socket.setEventListener('close', this.onDisconnect);
       socket.setEventListener('message', (msg) => {
-        const topic = msg.data.substr(0,2);
-        const data = JSON.parse(msg.data.substr(2));
+        const binary = typeof msg.data != 'string';
+        const topic = binary
+          ? String.fromCharCode.apply(null, new Uint8Array(msg.data, 0, 2))
+          : msg.data.substr(0,2);
+        const data = binary
+          ? cbor(new DataView(msg.data, 2))
+          : JSON.parse(msg.data.substr(2));
         if (Models.Prefixes.MESSAGE+this._topic == topic) setTimeout(() => observer.next(data), 0);
         else if (Models.Prefixes.SNAPSHOT+this._topic == topic)
           data.forEach(item => setTimeout(() => observer.next(item), 0));
@@ -93,6 +159,11 @@ export class Subscriber<T> extends Observable<T> implements ISubscribe<T> {
   };
 }
 
+export function page<T>(topic: string, msg: T): void {
+  if (socket.ws.readyState==1)
+    socket.ws.send(Models.Prefixes.SNAPSHOT + topic + JSON.stringify(msg));
+}
+
 export interface IFire<T> {
   fire(msg?: T): void;
 }
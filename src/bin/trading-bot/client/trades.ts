@@ -25,6 +25,8 @@ export class TradesComponent implements OnInit {
 
   private sortTimeout: number;
 
+  private pageBefore: string;
+
   @Input() product: Models.ProductAdvertisement;
 
   @Input() set setQuotingParameters(o: Models.QuotingParameters) {
@@ -64,6 +66,7 @@ export class TradesComponent implements OnInit {
     this.gridOptions.defaultColDef = { sortable: true, resizable: true };
     this.gridOptions.columnDefs = this.createColumnDefs();
     this.gridOptions.overlayNoRowsTemplate = `<span class="ag-overlay-no-rows-center">empty history of trades</span>`;
+    this.gridOptions.onBodyScroll = this.onBodyScroll;
 
     this.fireCxl = this.fireFactory
       .getFire(Models.Topics.CleanTrade);
@@ -124,6 +127,24 @@ export class TradesComponent implements OnInit {
     });
   }
 
+  private onBodyScroll = () => {
+    const count = this.gridOptions.api.getDisplayedRowCount();
+    if (!count || this.gridOptions.api.getLastDisplayedRow() < count - 1) return;
+    var before: number = 0;
+    var tradeId: string = "";
+    this.gridOptions.api.forEachNode((node: RowNode) => {
+      if (node.data.side === 'K' && node.data.Ktime && (!before || node.data.Ktime < before
+        || (node.data.Ktime === before && Number(node.data.tradeId) < Number(tradeId))
+      )) {
+        before = node.data.Ktime;
+        tradeId = node.data.tradeId;
+      }
+    });
+    if (!before || before + ':' + tradeId === this.pageBefore) return;
+    this.pageBefore = before + ':' + tradeId;
+    Subscribe.page(Models.Topics.Trades, {before: before, tradeId: tradeId});
+  }
+
   private addRowData = (t: Models.Trade) => {
     if (!this.gridOptions.api || this.product.base == null) return;
     if (t.Kqty<0) {
@@ -467,35 +467,91 @@ namespace tribeca {
     j = k.blob();
   };
 
-  struct MarketTakers: public Client::Broadcast<Trade> {
-    vector<Trade>  trades;
-            Amount takersBuySize60s  = 0,
-                   takersSellSize60s = 0;
+  struct TakerBucket {
+           Clock time     = 0;
+          Amount bidSize  = 0,
+                 askSize  = 0;
+           Price bidValue = 0,
+                 askValue = 0;
+    unsigned int bids     = 0,
+                 asks     = 0;
+    void add(const Trade &raw) {
+      if (raw.side == Side::Bid) {
+        bidSize  += raw.quantity;
+        bidValue += raw.quantity * raw.price;
+        bids++;
+      } else {
+        askSize  += raw.quantity;
+        askValue += raw.quantity * raw.price;
+        asks++;
+      }
+    };
+  };
+  static void to_json(json &j, const TakerBucket &k) {
+    j = {
+      {    "time", k.time                                      },
+      { "bidSize", k.bidSize                                   },
+      {"bidPrice", k.bidSize ? k.bidValue / k.bidSize : 0      },
+      {    "bids", k.bids                                      },
+      { "askSize", k.askSize                                   },
+      {"askPrice", k.askSize ? k.askValue / k.askSize : 0      },
+      {    "asks", k.asks                                      }
+    };
+  };
+
+  struct MarketTakers: public Client::Broadcast<TakerBucket> {
+    Amount takersBuySize60s  = 0,
+           takersSellSize60s = 0;
+    private:
+      deque<TakerBucket> buckets;
+             deque<Trade> tail;
+                     bool pending = false;
     public:
       MarketTakers(const KryptoNinja &bot)
         : Broadcast(bot)
       {};
+      void timer_1s() {
+        if (!buckets.empty() and buckets.back().time + 1e+3 <= Tstamp)
+          close();
+      };
       void timer_60s() {
+        expire(Tstamp);
         takersSellSize60s = takersBuySize60s = 0;
-        for (const auto &it : trades)
-          (it.side == Side::Bid
-            ? takersSellSize60s
-            : takersBuySize60s
-          ) += it.quantity;
-        trades.clear();
+        for (const TakerBucket &it : buckets) {
+          takersSellSize60s += it.bidSize;
+          takersBuySize60s  += it.askSize;
+        }
       };
       void read_from_gw(const Trade &raw) {
-        trades.push_back(raw);
-        broadcast();
+        tail.push_back(raw);
+        if (tail.size() > 100) tail.pop_front();
+        const Clock time = raw.time - raw.time % 1000;
+        if (buckets.empty() or buckets.back().time < time or !pending) {
+          close();
+          expire(time);
+          buckets.push_back({buckets.empty() ? time : max(time, buckets.back().time)});
+        }
+        buckets.back().add(raw);
+        pending = true;
       };
       mMatter about() const override {
         return mMatter::MarketTrade;
       };
       json blob() const override {
-        return trades.back();
+        return buckets.back();
       };
       json hello() override {
-        return trades;
+        return tail;
+      };
+    private:
+      void close() {
+        if (!pending) return;
+        pending = false;
+        broadcast();
+      };
+      void expire(const Clock &time) {
+        while (!buckets.empty() and buckets.front().time + 60e+3 <= time)
+          buckets.pop_front();
       };
   };
 
@@ -516,8 +572,8 @@ namespace tribeca {
       bool realtime() const override {
         return false;
       };
-      bool read_same_blob() const override {
-        return false;
+      size_t version() const override {
+        return versions(fairValue);
       };
       bool read_asap() const override {
         return false;
@@ -547,11 +603,52 @@ namespace tribeca {
     k.topAsk = j.value("ask", 0.0);
   };
 
-  struct Stdevs: public Sqlite::VectorBackup<Stdev> {
+  struct StdevSeries {
+           Price shift = 0;
+    unsigned int n     = 0;
+          double sum   = 0, sumC = 0,
+                 sq    = 0, sqC  = 0;
+    void reset() {
+      *this = {};
+    };
+    void add(const Price &value) {
+      if (!n++) shift = value;
+      const double diff = value - shift;
+      kahan(&sum, &sumC, diff);
+      kahan(&sq, &sqC, diff * diff);
+    };
+    void remove(const Price &value) {
+      if (!n or !--n) return reset();
+      const double diff = value - shift;
+      kahan(&sum, &sumC, -diff);
+      kahan(&sq, &sqC, -diff * diff);
+    };
+    double calc(Price *const mean, const double &factor) const {
+      if (!n) return 0;
+      const double diff = sum / n;
+      *mean = shift + diff;
+      return sqrt(fmax(0, sq / n - diff * diff)) * factor;
+    };
+    private:
+      static void kahan(double *const total, double *const c, const double &value) {
+        const double y = value - *c,
+                     t = *total + y;
+        *c = (t - *total) - y;
+        *total = t;
+      };
+  };
+
+  struct Stdevs: public Sqlite::VectorBackup<Stdev, Ring<Stdev>> {
     double top  = 0,  topMean = 0,
            fair = 0, fairMean = 0,
            bid  = 0,  bidMean = 0,
            ask  = 0,  askMean = 0;
+    private:
+      StdevSeries fvSeries,
+                  bidSeries,
+                  askSeries,
+                  topSeries;
+      unsigned int ticks = 0;
     private_ref:
       const Price         &fairValue;
       const QuotingParams &qp;
@@ -567,10 +664,27 @@ namespace tribeca {
       };
       void calc() {
         if (size() < 2) return;
-        fair = calc(&fairMean, "fv");
-        bid  = calc(&bidMean, "bid");
-        ask  = calc(&askMean, "ask");
-        top  = calc(&topMean, "top");
+        fair = fvSeries.calc(&fairMean, qp.quotingStdevProtectionFactor);
+        bid  = bidSeries.calc(&bidMean, qp.quotingStdevProtectionFactor);
+        ask  = askSeries.calc(&askMean, qp.quotingStdevProtectionFactor);
+        top  = topSeries.calc(&topMean, qp.quotingStdevProtectionFactor);
+      };
+      void push_back(const Stdev &row) override {
+        add(row);
+        VectorBackup::push_back(row);
+        if (++ticks >= limit()) resync();
+      };
+      void erase() override {
+        if (size() > limit())
+          for_each(begin(), end() - limit(), [&](const Stdev &it) {
+            remove(it);
+          });
+        VectorBackup::erase();
+      };
+      Report pull(const json &j) override {
+        const Report note = VectorBackup::pull(j);
+        resync();
+        return note;
       };
       mMatter about() const override {
         return mMatter::STDEVStats;
@@ -582,34 +696,26 @@ namespace tribeca {
         return 1e+3 * limit();
       };
     private:
-      double calc(Price *const mean, const string &type) const {
-        vector<Price> values;
+      void add(const Stdev &row) {
+        fvSeries.add(row.fv);
+        bidSeries.add(row.topBid);
+        askSeries.add(row.topAsk);
+        topSeries.add(row.topBid);
+        topSeries.add(row.topAsk);
+      };
+      void remove(const Stdev &row) {
+        fvSeries.remove(row.fv);
+        bidSeries.remove(row.topBid);
+        askSeries.remove(row.topAsk);
+        topSeries.remove(row.topBid);
+        topSeries.remove(row.topAsk);
+      };
+      void resync() {
+        ticks = 0;
+        for (StdevSeries *const it : {&fvSeries, &bidSeries, &askSeries, &topSeries})
+          it->reset();
         for (const Stdev &it : rows)
-          if (type == "fv")
-            values.push_back(it.fv);
-          else if (type == "bid")
-            values.push_back(it.topBid);
-          else if (type == "ask")
-            values.push_back(it.topAsk);
-          else if (type == "top") {
-            values.push_back(it.topBid);
-            values.push_back(it.topAsk);
-          }
-        return calc(mean, qp.quotingStdevProtectionFactor, values);
-      };
-      double calc(Price *const mean, const double &factor, const vector<Price> &values) const {
-        unsigned int n = values.size();
-        if (!n) return 0;
-        double sum = 0;
-        for (const Price &it : values) sum += it;
-        *mean = sum / n;
-        double sq_diff_sum = 0;
-        for (const Price &it : values) {
-          Price diff = it - *mean;
-          sq_diff_sum += diff * diff;
-        }
-        double variance = sq_diff_sum / n;
-        return sqrt(variance) * factor;
+          add(it);
       };
       string explainOK() const override {
         return "loaded % STDEV Periods";
@@ -628,7 +734,7 @@ namespace tribeca {
     };
   };
 
-  struct mFairHistory: public Sqlite::VectorBackup<Price> {
+  struct mFairHistory: public Sqlite::VectorBackup<Price, Ring<Price>> {
     public:
       mFairHistory(const KryptoNinja &bot)
         : VectorBackup(bot)
@@ -697,12 +803,40 @@ namespace tribeca {
       };
     private:
       void calcFromHistory() {
-        if ((qp._diffEwma >> 0) & 1) calcFromHistory(&mgEwmaVL, qp.veryLongEwmaPeriods,   "VeryLong");
-        if ((qp._diffEwma >> 1) & 1) calcFromHistory(&mgEwmaL,  qp.longEwmaPeriods,       "Long");
-        if ((qp._diffEwma >> 2) & 1) calcFromHistory(&mgEwmaM,  qp.mediumEwmaPeriods,     "Medium");
-        if ((qp._diffEwma >> 3) & 1) calcFromHistory(&mgEwmaS,  qp.shortEwmaPeriods,      "Short");
-        if ((qp._diffEwma >> 4) & 1) calcFromHistory(&mgEwmaXS, qp.extraShortEwmaPeriods, "ExtraShort");
-        if ((qp._diffEwma >> 5) & 1) calcFromHistory(&mgEwmaU,  qp.ultraShortEwmaPeriods, "UltraShort");
+        if (fairValue96h.empty() or !(qp._diffEwma & 0x3F)) return;
+        Price *const means[6] = {
+          &mgEwmaVL, &mgEwmaL, &mgEwmaM, &mgEwmaS, &mgEwmaXS, &mgEwmaU
+        };
+        const unsigned int periods[6] = {
+          qp.veryLongEwmaPeriods, qp.longEwmaPeriods,       qp.mediumEwmaPeriods,
+          qp.shortEwmaPeriods,    qp.extraShortEwmaPeriods, qp.ultraShortEwmaPeriods
+        };
+        const char *const names[6] = {
+          "VeryLong", "Long", "Medium", "Short", "ExtraShort", "UltraShort"
+        };
+        auto it = find_if(fairValue96h.begin(), fairValue96h.end(), [](const Price &value) {
+          return value;
+        });
+        if (it == fairValue96h.end()) return;
+        double alpha[6],
+               decay[6],
+               mean[6];
+        for (size_t k = 0; k < 6; ++k) {
+          alpha[k] = 2.0 / (periods[k] + 1);
+          decay[k] = 1 - alpha[k];
+          mean[k]  = *it;
+        }
+        while (++it != fairValue96h.end()) {
+          const Price value = *it;
+          for (size_t k = 0; k < 6; ++k)
+            mean[k] = alpha[k] * value + decay[k] * mean[k];
+        }
+        string reloaded;
+        for (size_t k = 0; k < 6; ++k)
+          if ((qp._diffEwma >> k) & 1)
+            reloaded += (reloaded.empty() ? "" : ", ")
+                      + to_string(*means[k] = mean[k]) + " " + names[k];
+        K.log("MG", "reloaded EWMA", reloaded);
       };
       void calc(Price *const mean, const unsigned int &periods, const Price &value) {
         if (*mean) {
@@ -713,14 +847,6 @@ namespace tribeca {
       void prepareHistory() {
         fairValue96h.push_back(fairValue);
       };
-      void calcFromHistory(Price *const mean, const unsigned int &periods, const string &name) {
-        unsigned int n = fairValue96h.size();
-        if (!n--) return;
-        unsigned int x = 0;
-        *mean = fairValue96h.front();
-        while (n--) calc(mean, periods, fairValue96h.at(++x));
-        K.log("MG", "reloaded " + to_string(*mean) + " EWMA " + name);
-      };
       void calcPositions() {
         calc(&mgEwmaVL, qp.veryLongEwmaPeriods,   fairValue);
         calc(&mgEwmaL,  qp.longEwmaPeriods,       fairValue);
@@ -917,6 +1043,7 @@ namespace tribeca {
       };
       void timer_1s() {
         stats.stdev.timer_1s(bids.cbegin()->price, asks.cbegin()->price);
+        stats.takerTrades.timer_1s();
       };
       void timer_60s() {
         stats.takerTrades.timer_60s();
@@ -1261,9 +1388,341 @@ namespace tribeca {
     {};
   };
 
-  struct TradesHistory: public Sqlite::VectorBackup<OrderFilled>,
+  //! \brief Append-only file of closed Trades, mapped in memory,
+  //!        stored as blocks of columns (to scan one field of all rows).
+  class TradesJournal {
+    private:
+      static constexpr unsigned int version = 1;
+      static constexpr size_t block = 4096,
+                              head  = 64,
+                              wide  = 11,
+                              width = block * (wide * 8 + 3);
+      enum class Column: size_t {
+        TradeId, Time, Ktime, Price, Quantity, Value, Fee, Kqty, Kprice, Kvalue, Kdiff,
+        Side, IsPong, Erased
+      };
+      struct Header {
+            char magic[8];
+        uint32_t version,
+                 block;
+        uint64_t count,
+                 erased;
+      };
+      //! \brief Bounds of the live rows of a block, so reads and erases
+      //!        skip every block that can not hold what they look for.
+      struct Span {
+         Clock first = 0,
+               last  = 0,
+               low   = 0,
+               high  = 0;
+        size_t rows  = 0;
+      };
+      const string magic = "K-trades";
+          string file;
+             int fd    = -1;
+            char *data = nullptr;
+          size_t bytes = 0;
+      vector<Span> spans;
+    public:
+      ~TradesJournal() {
+        close();
+      };
+      //! \brief     Map an existing journal, or create an empty one.
+      //! \param[in] name Path of the journal file.
+      //! \return    False if the file can not be used as a journal.
+      bool open(const string &name) {
+#ifndef _WIN32
+        close();
+        fd = ::open(name.data(), O_RDWR | O_CREAT | O_CLOEXEC, 0600);
+        if (fd < 0) return false;
+        struct stat st;
+        const bool fresh = !fstat(fd, &st) and !st.st_size;
+        if ((fresh and ftruncate(fd, head + width))
+          or !map(fstat(fd, &st) ? 0 : st.st_size)
+        ) {
+          close();
+          return false;
+        }
+        file = name;
+        if (fresh) {
+          memcpy(header()->magic, magic.data(), sizeof(header()->magic));
+          header()->version = version;
+          header()->block   = block;
+          header()->count   =
+          header()->erased  = 0;
+        } else if (magic.compare(0, magic.length(), header()->magic, sizeof(header()->magic))
+          or header()->version != version
+          or header()->block != block
+          or header()->count > capacity()
+          or header()->erased > header()->count
+        ) {
+          close();
+          return false;
+        }
+        spans.resize((header()->count + block - 1) / block);
+        for (size_t b = 0; b < spans.size(); ++b)
+          measure(b);
+        compact();
+        return true;
+#else
+        return false;
+#endif
+      };
+      bool opened() const {
+        return data;
+      };
+      size_t size() const {
+        return data
+          ? header()->count - header()->erased
+          : 0;
+      };
+      //! \brief  Copy a Trade at the end of the journal.
+      //! \return False if the file can not grow.
+      bool append(const OrderFilled &row) {
+        if (!data or (header()->count == capacity() and !grow()))
+          return false;
+        const size_t i = header()->count;
+        at<Clock> (Column::TradeId,  i) = strtoll(row.tradeId.data(), nullptr, 10);
+        at<Clock> (Column::Time,     i) = row.time;
+        at<Clock> (Column::Ktime,    i) = row.Ktime;
+        at<double>(Column::Price,    i) = row.price;
+        at<double>(Column::Quantity, i) = row.quantity;
+        at<double>(Column::Value,    i) = row.value;
+        at<double>(Column::Fee,      i) = row.feeCharged;
+        at<double>(Column::Kqty,     i) = row.Kqty;
+        at<double>(Column::Kprice,   i) = row.Kprice;
+        at<double>(Column::Kvalue,   i) = row.Kvalue;
+        at<double>(Column::Kdiff,    i) = row.Kdiff;
+        at<char>  (Column::Side,     i) = (char)row.side;
+        at<char>  (Column::IsPong,   i) = row.isPong;
+        at<char>  (Column::Erased,   i) = false;
+        if (i % block == 0) spans.emplace_back();
+        extend(spans.back(), i);
+        header()->count++;
+        return true;
+      };
+      //! \brief     Read the newest Trades closed before a cursor, newest first.
+      //! \param[in] before Skip Trades closed later than this time.
+      //! \param[in] id     Skip Trades closed at this time with this tradeId or higher,
+      //!                   so Trades closed together are not lost between pages.
+      //! \param[in] count  Maximum number of Trades to read.
+      vector<OrderFilled> page(const Clock &before, const Clock &id, const size_t &count) const {
+        using Key = pair<pair<Clock, Clock>, size_t>;
+        const pair<Clock, Clock> cursor = {before, id};
+        vector<size_t> blocks;
+        for (size_t b = 0; b < spans.size(); ++b)
+          if (spans[b].rows and make_pair(spans[b].first, spans[b].low) < cursor)
+            blocks.push_back(b);
+        sort(blocks.begin(), blocks.end(), [&](const size_t &a, const size_t &b) {
+          return make_pair(spans[a].last, spans[a].high) > make_pair(spans[b].last, spans[b].high);
+        });
+        vector<Key> keys;
+        for (const size_t &b : blocks) {
+          if (keys.size() == count and (!count
+            or make_pair(spans[b].last, spans[b].high) < keys.front().first
+          )) break;
+          for (size_t i = b * block; i < min((size_t)header()->count, (b + 1) * block); ++i)
+            if (!at<char>(Column::Erased, i)) {
+              const pair<Clock, Clock> key = {expiry(i), at<Clock>(Column::TradeId, i)};
+              if (key >= cursor) continue;
+              keys.push_back({key, i});
+              push_heap(keys.begin(), keys.end(), greater<>());
+              if (keys.size() > count) {
+                pop_heap(keys.begin(), keys.end(), greater<>());
+                keys.pop_back();
+              }
+            }
+        }
+        sort_heap(keys.begin(), keys.end(), greater<>());
+        vector<OrderFilled> rows;
+        for (const Key &it : keys)
+          rows.push_back(row(it.second));
+        return rows;
+      };
+      //! \return tradeIds of the erased Trades.
+      vector<string> erase(const string &tradeId) {
+        const Clock id = strtoll(tradeId.data(), nullptr, 10);
+        return erase_if([&](const Span &span) {
+          return span.low <= id and id <= span.high;
+        }, [&](const size_t &i) {
+          return at<Clock>(Column::TradeId, i) == id;
+        });
+      };
+      //! \return tradeIds of the erased Trades closed before some time.
+      vector<string> expire(const Clock &before) {
+        return erase_if([&](const Span &span) {
+          return span.first < before;
+        }, [&](const size_t &i) {
+          return expiry(i) < before;
+        });
+      };
+      //! \return True if a live Trade has this tradeId.
+      bool contains(const Clock &id) const {
+        for (size_t b = 0; b < spans.size(); ++b)
+          if (spans[b].rows and spans[b].low <= id and id <= spans[b].high)
+            for (size_t i = b * block; i < min((size_t)header()->count, (b + 1) * block); ++i)
+              if (!at<char>(Column::Erased, i) and at<Clock>(Column::TradeId, i) == id)
+                return true;
+        return false;
+      };
+      //! \return Highest tradeId of all live Trades, or 0.
+      Clock lastId() const {
+        Clock id = 0;
+        for (const Span &it : spans)
+          if (it.rows) id = max(id, it.high);
+        return id;
+      };
+      //! \return tradeIds of all erased Trades.
+      vector<string> clear() {
+        return erase_if([](const Span&) {
+          return true;
+        }, [](const size_t&) {
+          return true;
+        });
+      };
+    private:
+      Header *header() const {
+        return (Header*)data;
+      };
+      size_t capacity() const {
+        return (bytes - head) / width * block;
+      };
+      template <typename T> T &at(const Column &column, const size_t &i) const {
+        const size_t col = (size_t)column;
+        return *(T*)(data + head + (i / block) * width + (col < wide
+          ? col * 8 * block + (i % block) * 8
+          : wide * 8 * block + (col - wide) * block + (i % block)
+        ));
+      };
+      Clock expiry(const size_t &i) const {
+        return at<Clock>(Column::Ktime, i) ?: at<Clock>(Column::Time, i);
+      };
+      OrderFilled row(const size_t &i) const {
+        return {
+          (Side)at<char>(Column::Side, i),
+          at<double>(Column::Price,    i),
+          at<double>(Column::Quantity, i),
+          at<Clock> (Column::Time,     i),
+          to_string(at<Clock>(Column::TradeId, i)),
+          at<double>(Column::Value,    i),
+          at<double>(Column::Fee,      i),
+          at<double>(Column::Kqty,     i),
+          at<double>(Column::Kvalue,   i),
+          at<double>(Column::Kdiff,    i),
+          at<double>(Column::Kprice,   i),
+          at<Clock> (Column::Ktime,    i),
+          (bool)at<char>(Column::IsPong, i),
+          true
+        };
+      };
+      void extend(Span &span, const size_t &i) const {
+        const Clock closed = expiry(i),
+                    id     = at<Clock>(Column::TradeId, i);
+        if (span.rows++) {
+          span.first = min(span.first, closed);
+          span.last  = max(span.last,  closed);
+          span.low   = min(span.low,   id);
+          span.high  = max(span.high,  id);
+        } else span = {closed, closed, id, id, 1};
+      };
+      void measure(const size_t &b) {
+        spans[b] = {};
+        for (size_t i = b * block; i < min((size_t)header()->count, (b + 1) * block); ++i)
+          if (!at<char>(Column::Erased, i)) extend(spans[b], i);
+      };
+      //! \param[in] within Skips the blocks that can not hold any Trade to erase.
+      vector<string> erase_if(const function<bool(const Span&)> &within, const function<bool(const size_t&)> &fn) {
+        vector<string> erased;
+        if (!data) return erased;
+        for (size_t b = 0; b < spans.size(); ++b) {
+          if (!spans[b].rows or !within(spans[b])) continue;
+          const size_t before = erased.size();
+          for (size_t i = b * block; i < min((size_t)header()->count, (b + 1) * block); ++i)
+            if (!at<char>(Column::Erased, i) and fn(i)) {
+              at<char>(Column::Erased, i) = true;
+              header()->erased++;
+              erased.push_back(to_string(at<Clock>(Column::TradeId, i)));
+            }
+          if (erased.size() > before) measure(b);
+        }
+        if (!erased.empty()) compact();
+        return erased;
+      };
+      //! \brief Rewrite the live Trades into a new file once half the rows are erased,
+      //!        then replace the journal with it (a crash leaves the old file intact).
+      void compact() {
+#ifndef _WIN32
+        if (!header()->erased or header()->erased * 2 < header()->count) return;
+        TradesJournal live;
+        const string tmp = file + ".tmp";
+        ::unlink(tmp.data());
+        bool copied = live.open(tmp);
+        for (size_t i = 0; copied and i < header()->count; ++i)
+          if (!at<char>(Column::Erased, i))
+            copied = live.append(row(i));
+        live.close();
+        if (!copied or ::rename(tmp.data(), file.data()))
+          ::unlink(tmp.data());
+        else open(file);
+#endif
+      };
+      bool grow() {
+#ifndef _WIN32
+        const size_t size = bytes + width;
+        munmap(data, bytes);
+        data = nullptr;
+        if (!ftruncate(fd, size) and map(size)) return true;
+        close();
+#endif
+        return false;
+      };
+      bool map(const size_t &size) {
+#ifndef _WIN32
+        if (size < head + width) return false;
+        void *const mapped = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+        if (mapped == MAP_FAILED) return false;
+        data  = (char*)mapped;
+        bytes = size;
+        return true;
+#else
+        return false;
+#endif
+      };
+      void close() {
+#ifndef _WIN32
+        if (data) {
+          msync(data, bytes, MS_ASYNC);
+          munmap(data, bytes);
+        }
+        if (fd >= 0) ::close(fd);
+#endif
+        data  = nullptr;
+        bytes = 0;
+        fd    = -1;
+        spans.clear();
+      };
+  };
+
+  struct TradesHistory: public Sqlite::VectorBackup<OrderFilled, list<OrderFilled>>,
                         public Client::Broadcast<OrderFilled>,
                         public Client::Clicked {
+    public:
+      //! \brief Open pings by price, every one of them even if some share a price.
+      using Pings = multimap<Price, iterator>;
+    private:
+      struct Handle {
+                               iterator row;
+        multimap<Clock, iterator>::iterator expiry;
+      };
+      unordered_multimap<Clock, Handle> ids;
+                multimap<Clock, iterator> expiry;
+                                    Pings openBids,
+                                          openAsks;
+                                   Amount openBidsQty = 0,
+                                          openAsksQty = 0;
+                                    Clock lastId      = 0;
+                            TradesJournal journal;
+      static constexpr size_t pageSize = 1000;
     private_ref:
       const KryptoNinja   &K;
       const QuotingParams &qp;
@@ -1281,13 +1740,14 @@ namespace tribeca {
       {};
       void insert(const LastOrder &order) {
         const Amount fee = 0;
-        const Clock time = Tstamp;
+        const Clock time    = Tstamp,
+                    tradeId = max(time, lastId + 1);
         OrderFilled filled = {
           order.side,
           order.price,
           order.filled,
           time,
-          to_string(time),
+          to_string(tradeId),
           K.gateway->margin == Future::Spot
             ? abs(order.price * order.filled)
             : order.filled,
@@ -1307,35 +1767,63 @@ namespace tribeca {
           or qp.safety == QuotingSafety::PingPong
           or qp.safety == QuotingSafety::PingPoing
         ) broadcast_push_back(filled);
-        else {
-          Price widthPong = qp.widthPercentage
-            ? qp.widthPongPercentage * filled.price / 100
-            : qp.widthPong;
-          map<Price, string> matches;
-          for (OrderFilled &it : rows)
-            if (it.quantity - it.Kqty > 0 and it.side != filled.side) {
-              const Price combinedFee = K.gateway->makeFee * (it.price + filled.price);
-              if (filled.side == Side::Bid
-                  ? (it.price > filled.price + widthPong + combinedFee)
-                  : (it.price < filled.price - widthPong - combinedFee)
-              ) matches[it.price] = it.tradeId;
-            }
-          matchPong(
-            matches,
-            filled,
-            (qp.pongAt == PongAt::LongPingFair or qp.pongAt == PongAt::LongPingAggressive)
-              ? filled.side == Side::Ask
-              : filled.side == Side::Bid
-          );
-        }
+        else matchPong(
+          matches(filled),
+          filled
+        );
         if (qp.cleanPongsAuto)
           clearPongsAuto();
       };
+      const Pings &open(const Side &side) const {
+        return side == Side::Bid
+          ? openBids
+          : openAsks;
+      };
+      Amount openQty(const Side &side) const {
+        return side == Side::Bid
+          ? openBidsQty
+          : openAsksQty;
+      };
       mMatter about() const override {
         return mMatter::Trades;
       };
+      //! \return False to load all pings before any fill can be matched against them.
+      bool restore() const override {
+        return false;
+      };
       void erase() override {
-        if (crbegin()->Kqty < 0) rows.pop_back();
+        if (crbegin()->Kqty < 0) {
+          unindex(prev(end()));
+          rows.pop_back();
+        }
+      };
+      Report pull(const json &j) override {
+        const Report note = VectorBackup::pull(j);
+        ids.clear();
+        expiry.clear();
+        openBids.clear();
+        openAsks.clear();
+        openBidsQty = openAsksQty = 0;
+        for (auto it = begin(); it != end(); ++it)
+          index(it);
+        if (!journal.opened()
+          and K.arg<int>("journal")
+          and K.arg<string>("database") != ":memory:"
+        ) {
+          const string file = K.arg<string>("database") + ".trades";
+          if (journal.open(file))
+            K.log("DB", "loaded " + to_string(journal.size()) + " closed Trades from", file);
+          else K.logWar("DB", "Unable to use " + file + " as journal of closed Trades");
+        }
+        if (journal.opened()) {
+          vector<iterator> closed;
+          for (auto it = begin(); it != end(); ++it)
+            if (it->Kqty >= it->quantity) closed.push_back(it);
+          for (const iterator &it : closed)
+            archive(it, !journal.contains(id(it->tradeId)));
+          lastId = max(lastId, journal.lastId());
+        }
+        return note;
       };
       json blob() const override {
         if (crbegin()->Kqty == -1) return nullptr;
@@ -1347,95 +1835,216 @@ namespace tribeca {
       json hello() override {
         for (OrderFilled &it : rows)
           it.loadedFromDB = true;
-        return rows;
+        json j = rows;
+        for (const OrderFilled &it : journal.page(Tstamp + 1, 0, pageSize))
+          j.push_back(it);
+        return j;
+      };
+      json page(const json &j) override {
+        if (!journal.opened() or !j.is_object()) return nullptr;
+        return journal.page(
+          j.value("before", (Clock)0),
+          strtoll(j.value("tradeId", "").data(), nullptr, 10),
+          pageSize
+        );
       };
     private:
       void clearAll() {
         clear_if([](iterator) {
           return true;
         });
+        broadcast_erase(journal.clear());
       };
       void clearOne(const string &tradeId) {
-        clear_if([&tradeId](iterator it) {
-          return it->tradeId == tradeId;
-        }, true);
+        const auto it = ids.find(id(tradeId));
+        if (it != ids.end()) clear(it->second.row);
+        else broadcast_erase(journal.erase(tradeId));
       };
       void clearClosed() {
         clear_if([](iterator it) {
           return it->Kqty >= it->quantity;
         });
+        broadcast_erase(journal.clear());
       };
       void clearPongsAuto() {
         const Clock expire = Tstamp - (abs(qp.cleanPongsAuto) * 86400e3);
         const bool forcedClean = qp.cleanPongsAuto < 0;
-        clear_if([&expire, &forcedClean](iterator it) {
-          return (it->Ktime?:it->time) < expire and (
-            forcedClean
-            or it->Kqty >= it->quantity
-          );
-        });
-      };
-      void clear_if(const function<bool(iterator)> &fn, const bool &onlyOne = false) {
+        vector<iterator> expired;
+        for (auto it = expiry.begin(); it != expiry.end() and it->first < expire; ++it)
+          if (forcedClean or it->second->Kqty >= it->second->quantity)
+            expired.push_back(it->second);
+        for (const iterator &it : expired)
+          clear(it);
+        broadcast_erase(journal.expire(expire));
+      };
+      void clear_if(const function<bool(iterator)> &fn) {
         for (auto it = begin(); it != end();)
-          if (fn(it)) {
-            it->Kqty = -1;
-            it = send_push_erase(it);
-            if (onlyOne) break;
-          } else ++it;
-      };
-      void matchPong(const map<Price, string> &matches, OrderFilled pong, const bool &reverse) {
-        if (reverse) for (auto it = matches.crbegin(); it != matches.crend(); ++it) {
-          if (!matchPong(it->second, &pong)) break;
-        } else for (const auto &it : matches)
-          if (!matchPong(it.second, &pong)) break;
+          if (fn(it)) it = clear(it);
+          else ++it;
+      };
+      iterator clear(iterator it) {
+        unindex(it);
+        it->Kqty = -1;
+        return send_push_erase(it);
+      };
+      vector<iterator> matches(const OrderFilled &filled) const {
+        vector<iterator> matched;
+        const Side side = filled.side == Side::Bid
+          ? Side::Ask
+          : Side::Bid;
+        const Pings &pings = open(side);
+        if (pings.empty()) return matched;
+        const Price widthPong = qp.widthPercentage
+          ? qp.widthPongPercentage * filled.price / 100
+          : qp.widthPong;
+        const double fee = K.gateway->makeFee;
+        auto match = [&](const Pings::const_iterator &it) {
+          const Price combinedFee = fee * (it->first + filled.price);
+          return filled.side == Side::Bid
+            ? it->first > filled.price + widthPong + combinedFee
+            : it->first < filled.price - widthPong - combinedFee;
+        };
+        Pings::const_iterator from = pings.begin(),
+                              to   = pings.end();
+        if (filled.side == Side::Bid) {
+          from = pings.lower_bound((filled.price * (1 + fee) + widthPong) / (1 - fee));
+          while (from != pings.begin() and match(prev(from))) --from;
+          while (from != pings.end() and !match(from)) ++from;
+        } else {
+          to = pings.lower_bound((filled.price * (1 - fee) - widthPong) / (1 + fee));
+          while (to != pings.end() and match(to)) ++to;
+          while (to != pings.begin() and !match(prev(to))) --to;
+        }
+        Amount remaining = filled.quantity;
+        auto collect = [&](const Pings::const_iterator &it) {
+          matched.push_back(it->second);
+          remaining -= fmin(remaining, it->second->quantity - it->second->Kqty);
+          return remaining > 0;
+        };
+        if ((qp.pongAt == PongAt::LongPingFair or qp.pongAt == PongAt::LongPingAggressive)
+          ? filled.side == Side::Ask
+          : filled.side == Side::Bid
+        ) {
+          for (auto it = to; it != from;)
+            if (!collect(--it)) break;
+        } else for (auto it = from; it != to; ++it)
+          if (!collect(it)) break;
+        return matched;
+      };
+      void matchPong(const vector<iterator> &matched, OrderFilled pong) {
+        for (const iterator &it : matched)
+          if (!matchPong(it, &pong)) break;
         if (pong.quantity > 0) {
-          bool eq = false;
-          for (auto it = begin(); it != end(); ++it) {
-            if (it->price!=pong.price or it->side!=pong.side or it->quantity<=it->Kqty) continue;
-            eq = true;
+          const Pings &pings = open(pong.side);
+          const auto eq = pings.lower_bound(pong.price);
+          if (eq != pings.end() and eq->first == pong.price) {
+            const iterator it = eq->second;
+            unindex(it);
             it->time = pong.time;
             it->quantity = it->quantity + pong.quantity;
             it->value = it->value + pong.value;
             it->isPong = false;
             it->loadedFromDB = false;
-            it = send_push_erase(it);
-            break;
-          }
-          if (!eq) broadcast_push_back(pong);
+            send_push_erase(it);
+          } else broadcast_push_back(pong);
         }
       };
-      bool matchPong(const string &match, OrderFilled *const pong) {
-        for (auto it = begin(); it != end(); ++it) {
-          if (it->tradeId != match) continue;
-          Amount Kqty = fmin(pong->quantity, it->quantity - it->Kqty);
-          it->Ktime = pong->time;
-          it->Kprice = ((Kqty*pong->price) + (it->Kqty*it->Kprice)) / (it->Kqty+Kqty);
-          it->Kqty = it->Kqty + Kqty;
-          it->Kvalue = abs(it->Kqty*it->Kprice);
-          pong->quantity = pong->quantity - Kqty;
-          pong->value = abs(pong->price*pong->quantity);
-          if (it->quantity <= it->Kqty)
-            it->Kdiff = ((it->quantity * it->price) - (it->Kqty * it->Kprice))
-                      * (it->side == Side::Ask ? 1 : -1);
-          it->isPong = true;
-          it->loadedFromDB = false;
-          it = send_push_erase(it);
-          break;
-        }
+      bool matchPong(const iterator &it, OrderFilled *const pong) {
+        unindex(it);
+        Amount Kqty = fmin(pong->quantity, it->quantity - it->Kqty);
+        it->Ktime = pong->time;
+        it->Kprice = ((Kqty*pong->price) + (it->Kqty*it->Kprice)) / (it->Kqty+Kqty);
+        it->Kqty = it->Kqty + Kqty;
+        it->Kvalue = abs(it->Kqty*it->Kprice);
+        pong->quantity = pong->quantity - Kqty;
+        pong->value = abs(pong->price*pong->quantity);
+        if (it->quantity <= it->Kqty)
+          it->Kdiff = ((it->quantity * it->price) - (it->Kqty * it->Kprice))
+                    * (it->side == Side::Ask ? 1 : -1);
+        it->isPong = true;
+        it->loadedFromDB = false;
+        send_push_erase(it);
+        if (journal.opened() and it->quantity <= it->Kqty)
+          archive(it, true);
         return pong->quantity > 0;
       };
+      static Clock id(const string &tradeId) {
+        return strtoll(tradeId.data(), nullptr, 10);
+      };
+      void index(const iterator &it) {
+        if (it->Kqty < 0) return;
+        lastId = max(lastId, id(it->tradeId));
+        ids.insert({id(it->tradeId), {
+          it,
+          expiry.insert({it->Ktime ?: it->time, it})
+        }});
+        if (it->quantity - it->Kqty > 0) {
+          (it->side == Side::Bid
+            ? openBids
+            : openAsks
+          ).insert({it->price, it});
+          (it->side == Side::Bid
+            ? openBidsQty
+            : openAsksQty
+          ) += it->quantity - it->Kqty;
+        }
+      };
+      void unindex(const iterator &it) {
+        const auto range = ids.equal_range(id(it->tradeId));
+        auto handle = range.first;
+        while (handle != range.second and handle->second.row != it) ++handle;
+        if (handle == range.second) return;
+        expiry.erase(handle->second.expiry);
+        ids.erase(handle);
+        Pings &pings = it->side == Side::Bid
+          ? openBids
+          : openAsks;
+        const auto prices = pings.equal_range(it->price);
+        for (auto ping = prices.first; ping != prices.second; ++ping)
+          if (ping->second == it) {
+            pings.erase(ping);
+            Amount &qty = it->side == Side::Bid
+              ? openBidsQty
+              : openAsksQty;
+            qty = pings.empty() ? 0 : qty - (it->quantity - it->Kqty);
+            break;
+          }
+      };
       void broadcast_push_back(const OrderFilled &row) {
         rows.push_back(row);
+        broadcast_back();
+      };
+      void broadcast_back() {
+        index(prev(end()));
         backup();
         if (crbegin()->Kqty < 0) rbegin()->Kqty = -2;
         broadcast();
       };
       iterator send_push_erase(iterator it) {
-        OrderFilled row = *it;
-        it = rows.erase(it);
-        broadcast_push_back(row);
+        const iterator next_ = next(it);
+        rows.splice(rows.end(), rows, it);
+        broadcast_back();
         erase();
-        return it;
+        return next_;
+      };
+      //! \brief Move a closed Trade from memory and database into the journal,
+      //!        the UI keeps it as it was last broadcasted.
+      void archive(const iterator &it, const bool &append) {
+        if (append and !journal.append(*it)) return;
+        unindex(it);
+        rows.splice(rows.end(), rows, it);
+        it->Kqty = -1;
+        backup();
+        rows.pop_back();
+      };
+      void broadcast_erase(const vector<string> &tradeIds) {
+        for (const string &it : tradeIds) {
+          rows.emplace_back();
+          rbegin()->tradeId = it;
+          rbegin()->Kqty = -2;
+          broadcast();
+          rows.pop_back();
+        }
       };
       string explainOK() const override {
         return "loaded % historical Trades";
@@ -1443,16 +2052,29 @@ namespace tribeca {
   };
 
   struct RecentTrade {
-     Price price    = 0;
-    Amount quantity = 0;
-     Clock time     = 0;
-    RecentTrade(const Price &p, const Amount &q)
+           Price price    = 0;
+          Amount quantity = 0;
+           Clock time     = 0;
+    unsigned int id       = 0;
+    RecentTrade(const Price &p, const Amount &q, const unsigned int &i = 0)
       : price(p)
       , quantity(q)
       , time(Tstamp)
+      , id(i)
     {};
   };
   struct RecentTrades {
+    private:
+      struct Expiry {
+               Clock time;
+                Side side;
+               Price price;
+        unsigned int id;
+      };
+      deque<Expiry> expiry;
+       unsigned int sequence  = 0;
+             Amount buysTotal  = 0,
+                    sellsTotal = 0;
     private_ref:
       const QuotingParams &qp;
     public:
@@ -1470,33 +2092,44 @@ namespace tribeca {
         ? lastBuyPrice
         : lastSellPrice
       ) = order.price;
+      const RecentTrade trade(order.price, order.filled, ++sequence);
       (order.side == Side::Bid
         ? buys
         : sells
-      ).insert(pair<Price, RecentTrade>(
-        order.price,
-        RecentTrade(order.price, order.filled)
-      ));
+      ).insert(pair<Price, RecentTrade>(order.price, trade));
+      (order.side == Side::Bid
+        ? buysTotal
+        : sellsTotal
+      ) += trade.quantity;
+      expiry.push_back({trade.time, order.side, trade.price, trade.id});
     };
     void expire() {
-      if (!buys.empty()) expire(&buys);
-      if (!sells.empty()) expire(&sells);
+      const Clock now = Tstamp;
+      while (!expiry.empty()
+        and expiry.front().time + qp.tradeRateSeconds * 1e+3 <= now
+      ) {
+        expire(expiry.front());
+        expiry.pop_front();
+      }
       skip();
-      sumBuys = sum(&buys);
-      sumSells = sum(&sells);
+      sumBuys  = buys.empty()  ? buysTotal  = 0 : buysTotal;
+      sumSells = sells.empty() ? sellsTotal = 0 : sellsTotal;
     };
     private:
-      Amount sum(multimap<Price, RecentTrade> *const k) const {
-        Amount sum = 0;
-        for (const auto &it : *k)
-          sum += it.second.quantity;
-        return sum;
-      };
-      void expire(multimap<Price, RecentTrade> *const k) {
-        Clock now = Tstamp;
-        for (auto it = k->begin(); it != k->end();)
-          if (it->second.time + qp.tradeRateSeconds * 1e+3 > now) ++it;
-          else it = k->erase(it);
+      void expire(const Expiry &trade) {
+        multimap<Price, RecentTrade> &k = trade.side == Side::Bid
+          ? buys
+          : sells;
+        const auto range = k.equal_range(trade.price);
+        for (auto it = range.first; it != range.second; ++it)
+          if (it->second.id == trade.id) {
+            (trade.side == Side::Bid
+              ? buysTotal
+              : sellsTotal
+            ) -= it->second.quantity;
+            k.erase(it);
+            break;
+          }
       };
       void skip() {
         while (!(buys.empty() or sells.empty())) {
@@ -1504,14 +2137,22 @@ namespace tribeca {
           RecentTrade &sell = sells.begin()->second;
           if (sell.price < buy.price) break;
           const Amount buyQty = buy.quantity;
+          buysTotal  -= sell.quantity;
+          sellsTotal -= buyQty;
           buy.quantity -= sell.quantity;
           sell.quantity -= buyQty;
           if (buy.quantity <= 0)
-            buys.erase(buys.rbegin()->first);
+            erase(&buys, &buysTotal, buys.rbegin()->first);
           if (sell.quantity <= 0)
-            sells.erase(sells.begin()->first);
+            erase(&sells, &sellsTotal, sells.begin()->first);
         }
       };
+      void erase(multimap<Price, RecentTrade> *const k, Amount *const total, const Price price) {
+        const auto range = k->equal_range(price);
+        for (auto it = range.first; it != range.second; ++it)
+          *total -= it->second.quantity;
+        k->erase(range.first, range.second);
+      };
   };
 
   struct Safety: public Client::Broadcast<Safety> {
@@ -1567,8 +2208,8 @@ namespace tribeca {
       mMatter about() const override {
         return mMatter::TradeSafetyValue;
       };
-      bool read_same_blob() const override {
-        return false;
+      size_t version() const override {
+        return versions(buy, sell, combined, buyPing, sellPing);
       };
     private:
       void calcSizes() {
@@ -1633,48 +2274,46 @@ namespace tribeca {
             if (recentTrades.lastSellPrice and fairValue < recentTrades.lastSellPrice + widthPong)
               sellPing = recentTrades.lastSellPrice;
           } else {
-            map<Price, OrderFilled> tradesBuy;
-            map<Price, OrderFilled> tradesSell;
-            for (const OrderFilled &it: trades)
-              (it.side == Side::Bid ? tradesBuy : tradesSell)[it.price] = it;
+            const TradesHistory::Pings &tradesBuy  = trades.open(Side::Bid),
+                                       &tradesSell = trades.open(Side::Ask);
             Amount buyQty = 0,
                    sellQty = 0;
             if (qp.pongAt == PongAt::ShortPingFair or qp.pongAt == PongAt::ShortPingAggressive) {
-              matchBestPing(&tradesBuy, &buyPing, &buyQty, sellSize, widthPong, true);
-              matchBestPing(&tradesSell, &sellPing, &sellQty, buySize, widthPong);
-              if (!buyQty) matchFirstPing(&tradesBuy, &buyPing, &buyQty, sellSize, widthPong*-1, true);
-              if (!sellQty) matchFirstPing(&tradesSell, &sellPing, &sellQty, buySize, widthPong*-1);
+              matchBestPing(tradesBuy, &buyPing, &buyQty, sellSize, widthPong, true);
+              matchBestPing(tradesSell, &sellPing, &sellQty, buySize, widthPong);
+              if (!buyQty) matchFirstPing(tradesBuy, &buyPing, &buyQty, sellSize, widthPong*-1, true);
+              if (!sellQty) matchFirstPing(tradesSell, &sellPing, &sellQty, buySize, widthPong*-1);
             } else if (qp.pongAt == PongAt::LongPingFair or qp.pongAt == PongAt::LongPingAggressive) {
-              matchLastPing(&tradesBuy, &buyPing, &buyQty, sellSize, widthPong);
-              matchLastPing(&tradesSell, &sellPing, &sellQty, buySize, widthPong, true);
+              matchLastPing(tradesBuy, &buyPing, &buyQty, sellSize, widthPong);
+              matchLastPing(tradesSell, &sellPing, &sellQty, buySize, widthPong, true);
             } else if (qp.pongAt == PongAt::AveragePingFair or qp.pongAt == PongAt::AveragePingAggressive) {
-              matchAllPing(&tradesBuy, &buyPing, &buyQty, sellSize, widthPong);
-              matchAllPing(&tradesSell, &sellPing, &sellQty, buySize, widthPong);
+              matchAllPing(tradesBuy, &buyPing, &buyQty, sellSize, widthPong);
+              matchAllPing(tradesSell, &sellPing, &sellQty, buySize, widthPong);
             }
             if (buyQty) buyPing /= buyQty;
             if (sellQty) sellPing /= sellQty;
           }
         }
       };
-      void matchFirstPing(map<Price, OrderFilled> *tradesSide, Price *ping, Amount *qty, Amount qtyMax, Price width, bool reverse = false) {
+      void matchFirstPing(const TradesHistory::Pings &tradesSide, Price *ping, Amount *qty, Amount qtyMax, Price width, bool reverse = false) {
         matchPing(true, true, tradesSide, ping, qty, qtyMax, width, reverse);
       };
-      void matchBestPing(map<Price, OrderFilled> *tradesSide, Price *ping, Amount *qty, Amount qtyMax, Price width, bool reverse = false) {
+      void matchBestPing(const TradesHistory::Pings &tradesSide, Price *ping, Amount *qty, Amount qtyMax, Price width, bool reverse = false) {
         matchPing(true, false, tradesSide, ping, qty, qtyMax, width, reverse);
       };
-      void matchLastPing(map<Price, OrderFilled> *tradesSide, Price *ping, Amount *qty, Amount qtyMax, Price width, bool reverse = false) {
+      void matchLastPing(const TradesHistory::Pings &tradesSide, Price *ping, Amount *qty, Amount qtyMax, Price width, bool reverse = false) {
         matchPing(false, true, tradesSide, ping, qty, qtyMax, width, reverse);
       };
-      void matchAllPing(map<Price, OrderFilled> *tradesSide, Price *ping, Amount *qty, Amount qtyMax, Price width) {
+      void matchAllPing(const TradesHistory::Pings &tradesSide, Price *ping, Amount *qty, Amount qtyMax, Price width) {
         matchPing(false, false, tradesSide, ping, qty, qtyMax, width);
       };
-      void matchPing(bool _near, bool _far, map<Price, OrderFilled> *tradesSide, Price *ping, Amount *qty, Amount qtyMax, Price width, bool reverse = false) {
+      void matchPing(bool _near, bool _far, const TradesHistory::Pings &tradesSide, Price *ping, Amount *qty, Amount qtyMax, Price width, bool reverse = false) {
         int dir = width > 0 ? 1 : -1;
-        if (reverse) for (auto it = tradesSide->crbegin(); it != tradesSide->crend(); ++it) {
-          if (matchPing(_near, _far, ping, qty, qtyMax, width, dir * fairValue, dir * it->second.price, it->second.quantity, it->second.price, it->second.Kqty, reverse))
+        if (reverse) for (auto it = tradesSide.crbegin(); it != tradesSide.crend(); ++it) {
+          if (matchPing(_near, _far, ping, qty, qtyMax, width, dir * fairValue, dir * it->second->price, it->second->quantity, it->second->price, it->second->Kqty, reverse))
             break;
-        } else for (const auto &it : *tradesSide)
-          if (matchPing(_near, _far, ping, qty, qtyMax, width, dir * fairValue, dir * it.second.price, it.second.quantity, it.second.price, it.second.Kqty, reverse))
+        } else for (const auto &it : tradesSide)
+          if (matchPing(_near, _far, ping, qty, qtyMax, width, dir * fairValue, dir * it.second->price, it.second->quantity, it.second->price, it.second->Kqty, reverse))
             break;
       };
       bool matchPing(bool _near, bool _far, Price *ping, Amount *qty, Amount qtyMax, Price width, Price fv, Price price, Amount qtyTrade, Price priceTrade, Amount KqtyTrade, bool reverse) {
@@ -1753,8 +2392,8 @@ namespace tribeca {
       mMatter about() const override {
         return mMatter::TargetBasePosition;
       };
-      bool read_same_blob() const override {
-        return false;
+      size_t version() const override {
+        return versions(targetBasePosition, positionDivergence);
       };
     private:
       void calcPDiv() {
@@ -1853,8 +2492,11 @@ namespace tribeca {
       bool read_asap() const override {
         return false;
       };
-      bool read_same_blob() const override {
-        return false;
+      size_t version() const override {
+        return versions(
+          base.amount,  base.held,  base.value,  base.profit,
+          quote.amount, quote.held, quote.value, quote.profit
+        );
       };
     private:
       void calcFundsSilently() {
@@ -2240,8 +2882,11 @@ namespace tribeca {
       bool realtime() const override {
         return false;
       };
-      bool read_same_blob() const override {
-        return false;
+      size_t version() const override {
+        return versions(
+          quotes.bid.state, quotes.ask.state, sideAPR,
+          countWaiting, countWorking, zombies.size()
+        );
       };
     private:
       void states(const QuoteState &state) {
@@ -2688,15 +3333,30 @@ namespace tribeca {
       void timer_60s() {
         broadcast();
         orders_60s = 0;
+        for (RateLimit *const it : {
+          &K.gateway->ratelimit.place,
+          &K.gateway->ratelimit.replace,
+          &K.gateway->ratelimit.cancel
+        }) it->spent = it->throttled = 0;
       };
       json to_json() const {
         return {
-          {  "addr", K.gateway->unlock           },
-          {  "freq", orders_60s                  },
-          { "theme", K.arg<int>("ignore-moon")
-                       + K.arg<int>("ignore-sun")},
-          {"memory", K.memSize()                 },
-          {"dbsize", K.dbSize()                  }
+          {     "addr", K.gateway->unlock                            },
+          {     "freq", orders_60s                                   },
+          {    "theme", K.arg<int>("ignore-moon")
+                          + K.arg<int>("ignore-sun")                 },
+          {   "memory", K.memSize()                                  },
+          {   "dbsize", K.dbSize()                                   },
+          {    "dblag", K.dbLag()                                    },
+          {  "dbqueue", K.dbQueue()                                  },
+          {   "dbdrop", K.dbDropped()                                },
+          {    "quota", fmax(fmax(
+                          K.gateway->ratelimit.place.usage(60),
+                          K.gateway->ratelimit.replace.usage(60)),
+                          K.gateway->ratelimit.cancel.usage(60))     },
+          {"throttled", K.gateway->ratelimit.place.throttled
+                          + K.gateway->ratelimit.replace.throttled
+                          + K.gateway->ratelimit.cancel.throttled    }
         };
       };
       mMatter about() const override {
@@ -2707,10 +3367,112 @@ namespace tribeca {
     j = k.to_json();
   };
 
+  struct Requote {
+     bool pending  = false,
+          deferred = false;
+    Order raw;
+  };
+
+  struct Scheduler {
+    private:
+            Requote bid,
+                    ask;
+      deque<string> cancels;
+    private_ref:
+      const KryptoNinja &K;
+            Orders      &orders;
+    public:
+      Scheduler(const KryptoNinja &bot, Orders &o)
+        : K(bot)
+        , orders(o)
+      {};
+      void place(const Order &raw) {
+        Requote &requote = at(raw.side);
+        requote = {true, requote.pending and requote.deferred, raw};
+      };
+      void replace(const Price &price, const bool &isPong, const Order *const order) {
+        Requote &requote = at(order->side);
+        requote = {true, requote.pending and requote.deferred, *order};
+        requote.raw.price  = price;
+        requote.raw.isPong = isPong;
+      };
+      void drop(const Side &side) {
+        at(side).pending = false;
+      };
+      void clear() {
+        bid.pending =
+        ask.pending = false;
+      };
+      //! \brief Cancel now, or on the next flush() if throttled, unless asked
+      //!        from the UI, that is sent anyway and spends ahead of the bucket.
+      bool cancel(Order *const order, const bool &manual = false) {
+        if (!order) return false;
+        if (!manual and !K.gateway->ratelimit.cancel.ready()) {
+          if (find(cancels.begin(), cancels.end(), order->orderId) == cancels.end()) {
+            cancels.push_back(order->orderId);
+            K.gateway->ratelimit.cancel.defer();
+          }
+          return false;
+        }
+        if (!orders.cancel(order)) return false;
+        K.gateway->ratelimit.cancel.spend();
+        K.gateway->cancel(order);
+        return true;
+      };
+      //! \brief  Send the throttled cancels first, then the pending requotes
+      //!         only once no cancel is waiting anymore.
+      //! \note   A requote still waiting counts as throttled only once,
+      //!         even if newer quotes of the same side replace it.
+      //! \return Number of requotes sent.
+      unsigned int flush() {
+        while (!cancels.empty() and K.gateway->ratelimit.cancel.ready()) {
+          Order *const order = orders.find(cancels.front());
+          cancels.pop_front();
+          cancel(order);
+        }
+        unsigned int sent = 0;
+        for (Requote *const it : {&ask, &bid})
+          if (it->pending) {
+            if (cancels.empty() and limit(it->raw).ready()) {
+              it->pending = false;
+              sent += send(it->raw);
+            } else if (!it->deferred) {
+              it->deferred = true;
+              limit(it->raw).defer();
+            }
+          }
+        return sent;
+      };
+    private:
+      Requote &at(const Side &side) {
+        return side == Side::Bid
+          ? bid
+          : ask;
+      };
+      RateLimit &limit(const Order &raw) const {
+        return raw.exchangeId.empty()
+          ? K.gateway->ratelimit.place
+          : K.gateway->ratelimit.replace;
+      };
+      bool send(const Order &raw) {
+        if (raw.exchangeId.empty()) {
+          K.gateway->ratelimit.place.spend();
+          K.gateway->place(orders.upsert(raw));
+        } else {
+          Order *const order = orders.find(raw.orderId);
+          if (!orders.replace(raw.price, raw.isPong, order)) return false;
+          K.gateway->ratelimit.replace.spend();
+          K.gateway->replace(order);
+        }
+        return true;
+      };
+  };
+
   struct Broker: public Client::Clicked {
              Memory memory;
           Semaphore semaphore;
     AntonioCalculon calculon;
+          Scheduler scheduler;
     private_ref:
       const KryptoNinja   &K;
       const QuotingParams &qp;
@@ -2719,12 +3481,13 @@ namespace tribeca {
       Broker(const KryptoNinja &bot, const QuotingParams &q, Orders &o, const Buttons &b, const MarketLevels &l, const WalletPosition &w)
         : Clicked(bot, {
             {&b.submit, [&](const json &j) { placeOrder(j); }},
-            {&b.cancel, [&](const json &j) { cancelOrder(orders.find(j)); }},
-            {&b.cancelAll, [&]() { cancelOrders(); }}
+            {&b.cancel, [&](const json &j) { scheduler.cancel(orders.find(j), true); }},
+            {&b.cancelAll, [&]() { cancelOrders(true); }}
           })
         , memory(bot)
         , semaphore(bot)
         , calculon(bot, q, l, w)
+        , scheduler(bot, o)
         , K(bot)
         , qp(q)
         , orders(o)
@@ -2732,6 +3495,7 @@ namespace tribeca {
       bool ready() {
         if (semaphore.offline()) {
           calculon.offline();
+          scheduler.clear();
           return false;
         }
         return true;
@@ -2739,12 +3503,15 @@ namespace tribeca {
       void calcQuotes() {
         if (semaphore.paused()) {
           calculon.paused();
+          scheduler.clear();
           cancelOrders();
         } else {
+          const Metrics::Stopwatch recalculation(metrics.quotes);
           calculon.calcQuotes();
           quote2orders(calculon.quotes.ask);
           quote2orders(calculon.quotes.bid);
         }
+        memory.orders_60s += scheduler.flush();
       };
       void quote2orders(Quote &quote) {
         const vector<Order*> abandoned = abandon(quote);
@@ -2757,10 +3524,11 @@ namespace tribeca {
             cancelOrder(it);
           }
         );
-        if (quote.empty()) return;
-        if (replace)
-          replaceOrder(quote.price, quote.isPong, abandoned.back());
-        else placeOrder({
+        if (quote.empty())
+          scheduler.drop(quote.side);
+        else if (replace)
+          scheduler.replace(quote.price, quote.isPong, abandoned.back());
+        else scheduler.place({
           quote.side,
           quote.price,
           quote.size,
@@ -2768,7 +3536,6 @@ namespace tribeca {
           quote.isPong,
           K.gateway->randId()
         });
-        memory.orders_60s++;
       };
       void purge() {
         for (const Order *const it : calculon.purge())
@@ -2785,19 +3552,20 @@ namespace tribeca {
         return abandoned;
       };
       void placeOrder(const Order &raw) {
+        if (!K.gateway->ratelimit.place.ready()) {
+          K.gateway->ratelimit.place.defer();
+          K.logWar("QE", "Unable to place manual order, rate limit of " + K.gateway->exchange + " reached");
+          return;
+        }
+        K.gateway->ratelimit.place.spend();
         K.gateway->place(orders.upsert(raw));
       };
-      void replaceOrder(const Price &price, const bool &isPong, Order *const order) {
-        if (orders.replace(price, isPong, order))
-          K.gateway->replace(order);
-      };
       void cancelOrder(Order *const order) {
-        if (orders.cancel(order))
-          K.gateway->cancel(order);
+        scheduler.cancel(order);
       };
-      void cancelOrders() {
+      void cancelOrders(const bool &manual = false) {
         for (Order *const it : orders.working())
-          cancelOrder(it);
+          scheduler.cancel(it, manual);
       };
   };
 
@@ -2853,7 +3621,7 @@ namespace tribeca {
       };
     private:
       void calcQuotes() {
-        if (broker.ready() and levels.ready() and wallet.ready())
+        if (K.dbRestored() and broker.ready() and levels.ready() and wallet.ready())
           broker.calcQuotes();
         broker.purge();
       };
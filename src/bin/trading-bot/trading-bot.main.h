@@ -48,7 +48,9 @@ class TradingBot: public KryptoNinja {
           {"ignore-moon",  "1",      nullptr,                "do not switch UI to dark theme on moonlight"},
           {"debug-orders", "1",      nullptr,                "print detailed output about exchange messages"},
           {"debug-quotes", "1",      nullptr,                "print detailed output about quoting engine"},
-          {"debug-wallet", "1",      nullptr,                "print detailed output about target base position"}
+          {"debug-wallet", "1",      nullptr,                "print detailed output about target base position"},
+          {"journal",      "1",      nullptr,                "keep closed Trades in a memory-mapped file next to the database,"
+                                                             "\n" "so only open Trades are kept in memory and in the database"}
         },
         [&](MutableUserArguments &args) {
           if (arg<int>("debug"))
@@ -175,7 +175,7 @@ SCENARIO_METHOD(TradingBot, "ANY BTC/EUR") {
             REQUIRE(engine.wallet.safety.recentTrades.lastSellPrice == 1234.60);
             REQUIRE(engine.wallet.safety.recentTrades.buys.size() == 1);
             REQUIRE_FALSE(engine.wallet.safety.recentTrades.sells.size());
-            REQUIRE(engine.wallet.safety.recentTrades.sumBuys == 0.09876546);
+            REQUIRE(engine.wallet.safety.recentTrades.sumBuys == Approx(0.09876546));
             REQUIRE_FALSE(engine.wallet.safety.recentTrades.sumSells);
           }
           THEN("expired") {
@@ -332,6 +332,58 @@ SCENARIO_METHOD(TradingBot, "ANY BTC/EUR") {
         REQUIRE(Approx(0.8/3) == engine.wallet.safety.buySize);
       }
     }
+
+    WHEN("calcPrices") {
+      REQUIRE_NOTHROW(engine.wallet.safety.trades.Backup::push = [&]() {
+        INFO("push()");
+      });
+      REQUIRE_NOTHROW(engine.wallet.safety.trades.read = [&]() {
+        INFO("read()");
+      });
+      REQUIRE_NOTHROW(engine.wallet.base.value = 3.0);
+      REQUIRE_NOTHROW(engine.levels.fairValue = 500.0);
+      REQUIRE_NOTHROW(engine.qp.safety = tribeca::QuotingSafety::PingPong);
+      REQUIRE_NOTHROW(engine.wallet.safety.trades.insert({490.0, 0.1, Side::Bid, false}));
+      REQUIRE_NOTHROW(engine.wallet.safety.trades.insert({490.0, 0.3, Side::Bid, false}));
+      REQUIRE_NOTHROW(engine.wallet.safety.trades.insert({480.0, 0.2, Side::Bid, false}));
+      REQUIRE_NOTHROW(engine.qp.safety = tribeca::QuotingSafety::Boomerang);
+      REQUIRE_NOTHROW(engine.qp.pongAt = tribeca::PongAt::AveragePingFair);
+      REQUIRE_NOTHROW(engine.qp.widthPong = 1.0);
+
+      THEN("all pings at the same price") {
+        REQUIRE(engine.wallet.safety.trades.open(Side::Bid).size() == 3);
+        REQUIRE_NOTHROW(engine.wallet.safety.calc());
+        REQUIRE(Approx((490.0 * 0.4 + 480.0 * 0.2) / 0.6) == engine.wallet.safety.buyPing);
+        REQUIRE_FALSE(engine.wallet.safety.sellPing);
+      }
+    }
+  }
+
+  GIVEN("Stdevs") {
+    REQUIRE_NOTHROW(engine.qp.quotingStdevProtectionFactor = 1);
+    REQUIRE_NOTHROW(engine.qp.quotingStdevProtectionPeriods = 5);
+    REQUIRE_NOTHROW(engine.levels.stats.stdev.Backup::push = [&]() {
+      INFO("push()");
+    });
+    WHEN("assigned") {
+      vector<Price> fairHistory = { 268.05, 258.73, 239.82, 250.21, 224.49, 242.53, 248.25, 270.58, 252.77, 273.55 };
+      for (const Price &it : fairHistory) {
+        REQUIRE_NOTHROW(engine.levels.fairValue = it);
+        REQUIRE_NOTHROW(engine.levels.stats.stdev.timer_1s(it - 0.5, it + 0.5));
+      };
+      THEN("values") {
+        REQUIRE(engine.levels.stats.stdev.size() == 5);
+        double mean = 0, variance = 0;
+        for (auto it = fairHistory.end() - 5; it != fairHistory.end(); ++it) mean += *it / 5;
+        for (auto it = fairHistory.end() - 5; it != fairHistory.end(); ++it) variance += pow(*it - mean, 2) / 5;
+        REQUIRE(engine.levels.stats.stdev.fairMean == Approx(mean));
+        REQUIRE(engine.levels.stats.stdev.fair == Approx(sqrt(variance)));
+        REQUIRE(engine.levels.stats.stdev.bidMean == Approx(mean - 0.5));
+        REQUIRE(engine.levels.stats.stdev.bid == Approx(sqrt(variance)));
+        REQUIRE(engine.levels.stats.stdev.topMean == Approx(mean));
+        REQUIRE(engine.levels.stats.stdev.top == Approx(sqrt(variance + 0.25)));
+      }
+    }
   }
 
   GIVEN("Ewma") {
@@ -380,6 +432,28 @@ SCENARIO_METHOD(TradingBot, "ANY BTC/EUR") {
         }
       }
     }
+    WHEN("restored") {
+      REQUIRE_NOTHROW(engine.levels.stats.ewma.fairValue96h.Backup::push = [&]() {
+        INFO("push()");
+      });
+      REQUIRE_NOTHROW(engine.levels.stats.ewma.fairValue96h.push_back(300));
+      const json rows = { 100, 200 };
+      auto row = rows.begin();
+      const auto adopt = engine.levels.stats.ewma.fairValue96h.load([&](json &it) {
+        if (row == rows.end()) return false;
+        it = *row++;
+        return true;
+      }, rows.size());
+      REQUIRE(engine.levels.stats.ewma.fairValue96h.size() == 1);
+      THEN("adopted") {
+        REQUIRE_FALSE(adopt().first);
+        REQUIRE(engine.levels.stats.ewma.fairValue96h.size() == 3);
+        REQUIRE(engine.levels.stats.ewma.fairValue96h.front() == 100);
+        REQUIRE(engine.levels.stats.ewma.fairValue96h.at(1) == 200);
+        REQUIRE(engine.levels.stats.ewma.fairValue96h.back() == 300);
+        REQUIRE(engine.levels.stats.ewma.fairValue96h.snapshot() == json({ 100, 200, 300 }));
+      }
+    }
   }
 
   GIVEN("Broker") {
@@ -450,6 +524,26 @@ SCENARIO_METHOD(TradingBot, "ANY BTC/EUR") {
         REQUIRE(string::npos != engine.orders.blob().dump().find("{\"exchangeId\":\"\",\"isPong\":false,\"latency\":69,\"orderId\":\"" + randIds[4] + "\",\"price\":1234.51,\"quantity\":0.12345679,\"side\":1,\"status\":1,\"time\":" + to_string(time) + ",\"timeInForce\":0,\"type\":0}"));
       }
     }
+    WHEN("throttled") {
+      REQUIRE_NOTHROW(gateway->ratelimit.place.reset(1e-3, 1));
+      REQUIRE_NOTHROW(gateway->ratelimit.place.spend());
+      for (int i = 0; i < 3; i++) {
+        REQUIRE_NOTHROW(engine.broker.scheduler.place({Side::Bid, 1234.50 + i, 0.12345678, Tstamp, false, Random::uuid36Id()}));
+        REQUIRE_FALSE(engine.broker.scheduler.flush());
+      }
+      THEN("counted once") {
+        REQUIRE_FALSE(gateway->ratelimit.place.ready());
+        REQUIRE(gateway->ratelimit.place.spent == 1);
+        REQUIRE(gateway->ratelimit.place.throttled == 1);
+      }
+      THEN("counted again after sent") {
+        REQUIRE_NOTHROW(gateway->ratelimit.place.reset(1e-3, 1));
+        REQUIRE(engine.broker.scheduler.flush() == 1);
+        REQUIRE_NOTHROW(engine.broker.scheduler.place({Side::Bid, 1234.50, 0.12345678, Tstamp, false, Random::uuid36Id()}));
+        REQUIRE_FALSE(engine.broker.scheduler.flush());
+        REQUIRE(gateway->ratelimit.place.throttled == 2);
+      }
+    }
     WHEN("ready") {
       REQUIRE_NOTHROW(engine.levels.read_from_gw({
         { },
@@ -644,7 +738,84 @@ SCENARIO_METHOD(TradingBot, "ANY BTC/EUR") {
         REQUIRE(abs(actualBaseDelta - expectedBaseDelta) < 0.000000000001);
         REQUIRE(abs(actualQuoteDelta - expectedQuoteDelta) < 0.000000000001);
         REQUIRE(abs(actualDiff - expectedDiff) < 0.000000000001);
+        for (const Side &side : {Side::Bid, Side::Ask}) {
+          size_t openRows = 0;
+          Amount openQty = 0;
+          for (const auto &trade : engine.wallet.safety.trades)
+            if (trade.side == side and trade.quantity > trade.Kqty) {
+              openRows++;
+              openQty += trade.quantity - trade.Kqty;
+            }
+          REQUIRE(engine.wallet.safety.trades.open(side).size() == openRows);
+          REQUIRE(abs(engine.wallet.safety.trades.openQty(side) - openQty) < 0.000000000001);
+        }
+      }
+    }
+  }
+  GIVEN("TradesJournal") {
+    char name[] = "/tmp/K-test-XXXXXX";
+    const int fd = mkstemp(name);
+    REQUIRE(fd >= 0);
+    ::close(fd);
+    const string file = name;
+    tribeca::TradesJournal journal;
+    REQUIRE(journal.open(file));
+    for (Clock time = 1; time <= 5000; time++) {
+      tribeca::OrderFilled trade = {};
+      trade.side     = time % 2 ? Side::Ask : Side::Bid;
+      trade.price    = time;
+      trade.quantity =
+      trade.Kqty     = 0.01;
+      trade.time     = time;
+      trade.Ktime    = time + 1;
+      trade.tradeId  = to_string(time);
+      REQUIRE(journal.append(trade));
+    }
+    WHEN("paged") {
+      const vector<tribeca::OrderFilled> page = journal.page(4000, 0, 2);
+      REQUIRE(page.size() == 2);
+      REQUIRE(page.at(0).tradeId == "3998");
+      REQUIRE(page.at(0).side == Side::Bid);
+      REQUIRE(page.at(0).Ktime == 3999);
+      REQUIRE(page.at(1).tradeId == "3997");
+    }
+    WHEN("closed together") {
+      for (Clock time = 5001; time <= 5003; time++) {
+        tribeca::OrderFilled trade = {};
+        trade.time    = time;
+        trade.Ktime   = 6000;
+        trade.tradeId = to_string(time);
+        REQUIRE(journal.append(trade));
+      }
+      const vector<tribeca::OrderFilled> page = journal.page(Tstamp, 0, 2);
+      REQUIRE(page.at(0).tradeId == "5003");
+      REQUIRE(page.at(1).tradeId == "5002");
+      THEN("next page") {
+        const vector<tribeca::OrderFilled> next = journal.page(6000, 5002, 2);
+        REQUIRE(next.at(0).tradeId == "5001");
+        REQUIRE(next.at(1).tradeId == "5000");
+      }
+    }
+    WHEN("looked up") {
+      REQUIRE(journal.contains(4097));
+      REQUIRE(journal.lastId() == 5000);
+      REQUIRE(journal.erase("5000") == vector<string>({"5000"}));
+      REQUIRE_FALSE(journal.contains(5000));
+      REQUIRE(journal.lastId() == 4999);
+    }
+    WHEN("erased") {
+      REQUIRE(journal.erase("3998") == vector<string>({"3998"}));
+      REQUIRE(journal.page(4000, 0, 1).at(0).tradeId == "3997");
+      REQUIRE(journal.expire(3001).size() == 2999);
+      THEN("compacted") {
+        REQUIRE(journal.size() == 2000);
+        REQUIRE(journal.open(file));
+        REQUIRE(journal.size() == 2000);
+        REQUIRE(journal.page(Tstamp, 0, 1).at(0).tradeId == "5000");
+        REQUIRE(journal.clear().size() == 2000);
+        REQUIRE_FALSE(journal.size());
       }
     }
+    unlink(file.data());
   }
 }
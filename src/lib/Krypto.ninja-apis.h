@@ -93,7 +93,10 @@ namespace ₿ {
     static void update(const Order &raw, Order *const order) {
       if (!order) return;
       if (Status::Working == (     order->status     = raw.status
-      ) and !order->latency)       order->latency    = raw.time - order->time;
+      ) and !order->latency) {
+        order->latency = raw.time - order->time;
+        metrics.latency.observe(max(0LL, order->latency) * 1000);
+      }
       order->time = raw.time;
       if (!raw.exchangeId.empty()) order->exchangeId = raw.exchangeId;
       if (raw.price)               order->price      = raw.price;
@@ -152,6 +155,41 @@ namespace ₿ {
     k.manual      = j.value("manual", false);
   };
 
+  struct RateLimit {
+          double rate      = 0,
+                 burst     = 0,
+                 tokens    = 0;
+           Clock time      = 0;
+    unsigned int spent     = 0,
+                 throttled = 0;
+    void reset(const double &r, const double &b) {
+      tokens = burst = b;
+      rate   = r;
+      time   = Tstamp;
+    };
+    bool ready() const {
+      return !rate or available() >= 1;
+    };
+    void spend() {
+      spent++;
+      if (!rate) return;
+      tokens = available() - 1;
+      time   = Tstamp;
+    };
+    void defer() {
+      throttled++;
+    };
+    double usage(const double &seconds) const {
+      return rate
+        ? fmin(1, spent / (burst + rate * seconds))
+        : 0;
+    };
+    private:
+      double available() const {
+        return fmin(burst, tokens + (Tstamp - time) * rate / 1e+3);
+      };
+  };
+
   class GwExchangeData {
     public_friend:
       using DataEvent = variant<
@@ -173,6 +211,11 @@ namespace ₿ {
            askForReplace   = false,
            askForCancelAll = false;
       string (*randId)() = nullptr;
+      struct {
+        RateLimit place,
+                  replace,
+                  cancel;
+      } ratelimit;
       virtual void ask_for_data(const unsigned int &tick) = 0;
       virtual void wait_for_data(Loop *const loop) = 0;
       void data(const DataEvent &ev) {
@@ -453,12 +496,13 @@ namespace ₿ {
         countdown = 7;
         print("WS " + reason + ", reconnecting in " + to_string(countdown) + "s.");
       };
-      bool accept_msg(const string &msg) {
+      bool accept_msg(const string &msg, Metrics::Counter &parsed = metrics.ws) {
         const bool next = !msg.empty();
         if (next) {
-          if (json::accept(msg))
+          if (json::accept(msg)) {
+            parsed.add();
             consume(json::parse(msg));
-          else print("WS Error: Unsupported data format");
+          } else print("WS Error: Unsupported data format");
         }
         return next;
       };
@@ -519,7 +563,7 @@ namespace ₿ {
         CURLcode rc;
         if (CURLE_OK != (rc = WebSocketTwin::send_recv()))
           print(string("CURL recv Error: ") + curl_easy_strerror(rc));
-        while (accept_msg(WebSocketTwin::unframe()));
+        while (accept_msg(WebSocketTwin::unframe(), metrics.twin));
       };
   };
   class GwApiWsFix: public GwApiWs,
@@ -564,7 +608,7 @@ namespace ₿ {
         CURLcode rc;
         if (CURLE_OK != (rc = FixSocket::send_recv()))
           print(string("CURL recv FIX Error: ") + curl_easy_strerror(rc));
-        while (accept_msg(FixSocket::unframe()));
+        while (accept_msg(FixSocket::unframe(), metrics.fix));
       };
   };
 
@@ -575,6 +619,9 @@ namespace ₿ {
         http   = "https://api.binance.com";
         ws     = "wss://stream.binance.com:9443/ws";
         randId = Random::uuid36Id;
+        ratelimit.place.reset(10, 10);
+        ratelimit.replace.reset(10, 10);
+        ratelimit.cancel.reset(20, 20);
         webMarket = "https://www.binance.com/en/trade/";
         webOrders = "https://www.binance.com/en/my/orders/exchange/tradeorder";
       };
@@ -653,6 +700,9 @@ namespace ₿ {
         ws     = "wss://www.bitmex.com/realtime";
         randId = Random::uuid36Id;
         askForReplace = true;
+        ratelimit.place.reset(1, 30);
+        ratelimit.replace.reset(1, 30);
+        ratelimit.cancel.reset(1, 30);
         webMarket = "https://www.bitmex.com/app/trade/";
         webOrders = "https://www.bitmex.com/app/orderHistory";
       };
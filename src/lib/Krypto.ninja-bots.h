@@ -411,11 +411,20 @@ namespace ₿ {
         if (!arg<int>("naked")) long_options.push_back(
           {"naked",        "1",      nullptr,  "do not display CLI, print output to stdout instead"}
         );
-        if (databases) long_options.push_back(
+        if (databases) for (const Argument &it : (vector<Argument>){
           {"database",     "FILE",   "",       "set alternative PATH to database filename,"
                                                "\n" "default PATH is '" K_HOME "/db/K-*.db',"
-                                               "\n" "or use ':memory:' (see sqlite.org/inmemorydb.html)"}
-        );
+                                               "\n" "or use ':memory:' (see sqlite.org/inmemorydb.html)"},
+          {"db-queue",     "NUMBER", "8192",   "set NUMBER of maximum rows waiting to be written"
+                                               "\n" "into the database by the background writer"},
+          {"db-overflow",  "1",      nullptr,  "drop new rows when --db-queue is full,"
+                                               "\n" "instead of waiting for the database writer"},
+          {"db-binary",    "1",      nullptr,  "store new rows as MessagePack instead of JSON text"
+                                               "\n" "(old rows of both kinds are always loadable)"},
+          {"db-migrate",   "1",      nullptr,  "rewrite all rows of the database as set by --db-binary and quit"},
+          {"snapshot",     "NUMBER", "0",      "set NUMBER of minutes between warm restart snapshots,"
+                                               "\n" "written next to the database file (always on exit)"}
+        }) long_options.push_back(it);
         if (!arg<int>("headless")) for (const Argument &it : (vector<Argument>){
           {"headless",     "1",      nullptr,  "do not listen for UI connections,"
                                                "\n" "all other UI related arguments will be ignored"},
@@ -423,6 +432,16 @@ namespace ₿ {
           {"whitelist",    "IP",     "",       "set IP or csv of IPs to allow UI connections,"
                                                "\n" "alien IPs will get a zip-bomb instead"},
           {"client-limit", "NUMBER", "7",      "set NUMBER of maximum concurrent UI connections"},
+          {"client-queue", "NUMBER", "4",      "set NUMBER of megabytes pending to be sent to a UI connection,"
+                                               "\n" "before it is disconnected for being too slow,"
+                                               "\n" "or use '0' to not limit the queue; default NUMBER is '4'"},
+          {"deflate",      "NUMBER", "0",      "set NUMBER between '1' and '9' to compress UI messages"
+                                               "\n" "with permessage-deflate (higher is smaller but slower),"
+                                               "\n" "default NUMBER is '0' to not compress"},
+          {"no-takeover",  "1",      nullptr,  "compress each UI message alone (no context takeover),"
+                                               "\n" "using less memory per client but more bandwidth"},
+          {"ui-thread",    "1",      nullptr,  "serve UI connections from a separate thread,"
+                                               "\n" "so they never delay the trading loop"},
           {"port",         "NUMBER", "3000",   "set NUMBER of an open port to listen for UI connections"
                                                "\n" "default NUMBER is '3000'"},
           {"user",         "WORD",   "",       "set allowed WORD as username for UI connections"},
@@ -554,6 +573,7 @@ namespace ₿ {
 #endif
           args["naked"] = 1;
         if (args.find("database") != args.end()) {
+          args["db-queue"] = max(1, arg<int>("db-queue"));
           args["diskdata"] = "";
           if (arg<string>("database").empty() or arg<string>("database") == ":memory:")
             (arg<string>("database") == ":memory:"
@@ -568,6 +588,11 @@ namespace ₿ {
         if (!arg<int>("headless")) {
           if (arg<int>("latency") or !arg<int>("port") or !arg<int>("client-limit"))
             args["headless"] = 1;
+          args["deflate"] = max(0, min(9, arg<int>("deflate")));
+          args["client-queue"] = max(0, min(1024, arg<int>("client-queue")));
+#if defined _WIN32 or defined __APPLE__
+          args["ui-thread"] = 0;
+#endif
           args["B64auth"] = (!arg<int>("headless")
             and !arg<string>("user").empty() and !arg<string>("pass").empty()
           ) ? Text::B64(arg<string>("user") + ':' + arg<string>("pass"))
@@ -712,6 +737,23 @@ namespace ₿ {
             if (push) push();
           };
           virtual Report pull(const json &j) = 0;
+          //! \brief     Decode all rows into a detached container.
+          //! \param[in] next  Fills the next row, or returns false after the last one.
+          //! \param[in] count Allows to reserve capacity for all rows.
+          //! \return    Job that adopts the rows (before any newer row) and calls pull().
+          virtual function<Report()> load(const function<bool(json&)> &next, const size_t&) {
+            json j = json::array();
+            for (json row; next(row);)
+              j.push_back(move(row));
+            return [this, j = move(j)]() {
+              return pull(j);
+            };
+          };
+          virtual json snapshot() const {
+            return json::array({blob()});
+          };
+          //! \return True if the rows may load in the background while the engine runs.
+          virtual bool   restore()   const { return false; };
           virtual string increment() const { return "NULL"; };
           virtual double limit()     const { return 0; };
           virtual Clock  lifetime()  const { return 0; };
@@ -747,18 +789,18 @@ namespace ₿ {
             return "loaded last % OK";
           };
       };
-      template <typename T> class VectorBackup: public Backup {
+      template <typename T, typename Container = vector<T>> class VectorBackup: public Backup {
         public:
           VectorBackup(const Sqlite &sqlite)
             : Backup(sqlite)
           {};
-          vector<T> rows;
-          using reference              = typename vector<T>::reference;
-          using const_reference        = typename vector<T>::const_reference;
-          using iterator               = typename vector<T>::iterator;
-          using const_iterator         = typename vector<T>::const_iterator;
-          using reverse_iterator       = typename vector<T>::reverse_iterator;
-          using const_reverse_iterator = typename vector<T>::const_reverse_iterator;
+          Container rows;
+          using reference              = typename Container::reference;
+          using const_reference        = typename Container::const_reference;
+          using iterator               = typename Container::iterator;
+          using const_iterator         = typename Container::const_iterator;
+          using reverse_iterator       = typename Container::reverse_iterator;
+          using const_reverse_iterator = typename Container::const_reverse_iterator;
           iterator                 begin()       noexcept { return rows.begin();   };
           const_iterator           begin() const noexcept { return rows.begin();   };
           const_iterator          cbegin() const noexcept { return rows.cbegin();  };
@@ -777,9 +819,11 @@ namespace ₿ {
           const_reference             at(size_t n) const  { return rows.at(n);     };
           virtual void erase() {
             if (size() > limit())
-              rows.erase(begin(), end() - limit());
+              rows.erase(begin(), next(begin(), size() - limit()));
           };
           virtual void push_back(const T &row) {
+            if constexpr (is_same_v<Container, Ring<T>>)
+              rows.reserve(limit() + 1);
             rows.push_back(row);
             backup();
             erase();
@@ -789,6 +833,28 @@ namespace ₿ {
               rows.push_back(it);
             return report(empty());
           };
+          function<Report()> load(const function<bool(json&)> &next, const size_t &count) override {
+            const auto loaded = make_shared<Container>();
+            if constexpr (!is_same_v<Container, list<T>>)
+              loaded->reserve(count);
+            for (json row; next(row);)
+              loaded->push_back(row);
+            return [this, loaded]() {
+              for (const T &it : rows)
+                loaded->push_back(it);
+              rows = move(*loaded);
+              return pull(json::array());
+            };
+          };
+          json snapshot() const override {
+            json j = json::array();
+            for (const T &it : rows)
+              j.push_back(it);
+            return j;
+          };
+          bool restore() const override {
+            return true;
+          };
           json blob() const override {
             return back();
           };
@@ -800,70 +866,411 @@ namespace ₿ {
     protected:
       bool databases = false;
     private:
+      static constexpr unsigned int version = 1;
+      const string magic = "K-snapshot";
+      struct Statements {
+        sqlite3_stmt *erase       = nullptr,
+                     *erase_id    = nullptr,
+                     *insert      = nullptr,
+                     *fingerprint = nullptr;
+                string table;
+                Backup *data      = nullptr;
+      };
+      struct Row {
+        const Statements *sql    = nullptr;
+                   Clock  time   = 0,
+                          cut    = 0;
+                    bool  id     = false;
+               long long  incr   = 0;
+                    bool  binary = false;
+                  string  text;
+                    json  state;
+      };
       sqlite3 *db = nullptr;
       string disk = "main";
       mutable vector<Backup*> tables;
+      list<future<function<Backup::Report()>>> restores;
+        list<Statements> statements;
+            Channel<Row> queue;
+                  thread writer;
+                   mutex sleep;
+      condition_variable wakeup;
+            atomic<bool> sleeping = {false},
+                         stopped  = {false};
+           atomic<Clock> lag      = {0};
+          atomic<size_t> dropped  = {0};
+                    bool overflow = false,
+                         binary   = false;
+                  string snapfile;
+            unsigned int snapshots = 0;
+                   Clock frozen    = 0;
+                  size_t restoring = 0;
+    public:
+      Clock dbLag() const {
+        return lag;
+      };
+      size_t dbQueue() const {
+        return queue.size();
+      };
+      size_t dbDropped() const {
+        return dropped;
+      };
+      //! \brief     Serialize a row as MessagePack or as JSON text.
+      //! \param[in] blob   Any json value.
+      //! \param[in] binary Allows to choose MessagePack, stored as BLOB.
+      static string encode(const json &blob, const bool &binary) {
+        string text;
+        if (binary) json::to_msgpack(blob, text);
+        else text = blob.dump();
+        return text;
+      };
+      //! \brief     Parse a row, as tagged by its SQLite storage class.
+      //! \param[in] data   Row bytes.
+      //! \param[in] size   Row length.
+      //! \param[in] binary Storage class was BLOB, so it is MessagePack.
+      static json decode(const char *const data, const size_t &size, const bool &binary) {
+        return binary
+          ? json::from_msgpack(data, data + size)
+          : json::parse(data, data + size);
+      };
+      bool dbRestored() const {
+        return !restoring;
+      };
     protected:
-      void backups(const Option *const K) {
-        if (sqlite3_open(K->arg<string>("database").data(), &db))
-          error("DB", sqlite3_errmsg(db));
-        K->log("DB", "loaded OK from", K->arg<string>("database"));
-        if (!K->arg<string>("diskdata").empty()) {
-          exec("ATTACH '" + K->arg<string>("diskdata") + "' AS " + (disk = "disk") + ";");
-            K->log("DB", "loaded OK from", K->arg<string>("diskdata"));
-        }
-        exec("PRAGMA " + disk + ".journal_mode = WAL;"
-             "PRAGMA " + disk + ".synchronous = NORMAL;");
+      void migrations(const Option *const K) {
+        if (!K->arg<int>("db-migrate")) return;
+        open(K);
+        size_t rows = 0;
+        for (auto &it : tables)
+          rows += migrate(it);
+        exit("DB migrated " + to_string(rows) + " rows to "
+          + (binary ? "MessagePack" : "JSON text"));
+      };
+      void backups(const Option *const K, Loop *const loop) {
+        open(K);
+        if (K->arg<string>("database") != ":memory:")
+          snapfile = K->arg<string>("database") + ".snapshot";
+        snapshots = K->arg<int>("snapshot");
+        const json warm = thaw();
+        const Clock until = frozen = Tstamp;
+        vector<Backup*> history;
+        size_t warmed = 0;
         for (auto &it : tables) {
-          const Backup::Report note = it->pull(select(it));
-          if (!note.second.empty()) {
-            if (note.first)
-              K->logWar("DB", note.second);
-            else K->log("DB", note.second);
-          }
-          it->push = [this, it]() {
-            insert(it);
+          const string table = schema(it);
+          exec(create(table));
+          upgrade(it);
+          statements.push_back(prepare(it));
+          it->push = [this, it, sql = &statements.back()]() {
+            insert(it, sql);
           };
+          exec(truncate(table, it->lifetime()));
+          const bool fresh = warm.find(table) != warm.end()
+            and warm.at(table).value("fingerprint", json()) == fingerprint(statements.back());
+          if (fresh) {
+            report(K, it->pull(warm.at(table).at("rows")));
+            warmed++;
+          }
+          else if (!it->restore() or K->arg<string>("database") == ":memory:")
+            report(K, select(it, until)());
+          else history.push_back(it);
         }
         tables.clear();
+        if (warmed)
+          K->log("DB", "loaded " + to_string(warmed) + " tables from warm snapshot", snapfile);
+        for (auto &it : history) {
+          restores.emplace_back();
+          future<function<Backup::Report()>> &rows = restores.back();
+          Loop::Async *const ready = loop->async([this, K, &rows]() {
+            if (rows.valid()) {
+              report(K, rows.get()());
+              restoring--;
+            }
+          });
+          restoring++;
+          rows = ::async(launch::async, [this, K, it, until, ready]() {
+            function<Backup::Report()> adopt;
+            sqlite3 *conn = nullptr;
+            try {
+              conn = reader(K);
+              adopt = select(it, until, conn);
+            } catch (const exception &e) {
+              adopt = [reason = string(e.what())]() -> Backup::Report {
+                error("DB", reason);
+                return {};
+              };
+            }
+            sqlite3_close_v2(conn);
+            ready->wakeup();
+            return adopt;
+          });
+        }
+        if (!snapfile.empty() and snapshots)
+          loop->timer_1s([&](const unsigned int&) {
+            if (Tstamp - frozen >= snapshots * 60e+3)
+              checkpoint();
+          });
+        overflow = K->arg<int>("db-overflow");
+        queue.reserve(K->arg<int>("db-queue"));
+        writer = thread([&]() {
+          drain();
+        });
       };
       void blackhole() {
         for (auto &it : tables)
           it->push = nullptr;
         tables.clear();
       };
+      void without_backlog() {
+        if (!writer.joinable() or writer.get_id() == this_thread::get_id()) return;
+        checkpoint();
+        stopped = true;
+        awake();
+        writer.join();
+      };
     private:
-      json select(Backup *const data) {
+      void open(const Option *const K) {
+        if (sqlite3_open_v2(K->arg<string>("database").data(), &db,
+          SQLITE_OPEN_READWRITE | SQLITE_OPEN_CREATE | SQLITE_OPEN_FULLMUTEX, nullptr
+        )) error("DB", sqlite3_errmsg(db));
+        K->log("DB", "loaded OK from", K->arg<string>("database"));
+        if (!K->arg<string>("diskdata").empty()) {
+          exec("ATTACH '" + K->arg<string>("diskdata") + "' AS " + (disk = "disk") + ";");
+            K->log("DB", "loaded OK from", K->arg<string>("diskdata"));
+        }
+        exec("PRAGMA " + disk + ".journal_mode = WAL;"
+             "PRAGMA " + disk + ".synchronous = NORMAL;");
+        binary = K->arg<int>("db-binary");
+      };
+      static void report(const Option *const K, const Backup::Report &note) {
+        if (!note.second.empty()) {
+          if (note.first)
+            K->logWar("DB", note.second);
+          else K->log("DB", note.second);
+        }
+      };
+      //! \brief Open a read-only connection, so a loader never scans a table
+      //!        while the writer thread changes it through the same connection.
+      sqlite3 *reader(const Option *const K) const {
+        sqlite3 *conn = nullptr;
+        if (sqlite3_open_v2(K->arg<string>("database").data(), &conn,
+          SQLITE_OPEN_READONLY | SQLITE_OPEN_NOMUTEX, nullptr
+        )) {
+          const string reason = sqlite3_errmsg(conn);
+          sqlite3_close(conn);
+          throw runtime_error(reason);
+        }
+        if (disk != "main")
+          sqlite3_exec(conn, ("ATTACH '" + K->arg<string>("diskdata") + "' AS " + disk + ";").data(),
+            nullptr, nullptr, nullptr);
+        return conn;
+      };
+      function<Backup::Report()> select(Backup *const data, const Clock &until, sqlite3 *const conn = nullptr) {
         const string table = schema(data);
-        json result = json::array();
-        exec(
-          create(table)
-          + truncate(table, data->lifetime())
-          + "SELECT json FROM " + table + " ORDER BY time ASC;",
-          &result
-        );
-        return result;
-      };
-      void insert(Backup *const data) {
-        const string table    = schema(data);
-        const json   blob     = data->blob();
-        const double limit    = data->limit();
-        const Clock  lifetime = data->lifetime();
-        const string incr     = data->increment();
-        const string sql      = (
-          (incr != "NULL" or !limit or lifetime)
-            ? "DELETE FROM " + table + (
-              incr != "NULL"
-                ? " WHERE id = " + incr
-                : (limit ? " WHERE time < " + to_string(Tstamp - lifetime) : "")
-            ) + ";" : ""
-        ) + (
-          blob.is_null()
-            ? ""
-            : "INSERT INTO " + table
-              + " (id,json) VALUES(" + incr + ",'" + blob.dump() + "');"
-        );
-        exec(sql);
+        sqlite3_stmt *const count = prepare("SELECT COUNT(*) FROM " + table + " WHERE time < ?1;", conn),
+                     *const stmt  = prepare("SELECT json FROM " + table + " WHERE time < ?1 ORDER BY time ASC;", conn);
+        sqlite3_bind_int64(count, 1, until);
+        sqlite3_bind_int64(stmt, 1, until);
+        const size_t rows = sqlite3_step(count) == SQLITE_ROW
+          ? sqlite3_column_int64(count, 0)
+          : 0;
+        sqlite3_finalize(count);
+        const function<Backup::Report()> adopt = data->load([&](json &row) {
+          if (sqlite3_step(stmt) != SQLITE_ROW) return false;
+          row = column(stmt, 0);
+          return true;
+        }, rows);
+        sqlite3_finalize(stmt);
+        return adopt;
+      };
+      size_t migrate(Backup *const data) {
+        const string table = schema(data);
+        size_t rows = 0;
+        exec(create(table) + "BEGIN;");
+        sqlite3_stmt *const stmt   = prepare("SELECT id,json FROM " + table + ";"),
+                     *const update = prepare("UPDATE " + table + " SET json = ?2 WHERE id = ?1;");
+        while (sqlite3_step(stmt) == SQLITE_ROW)
+          if ((sqlite3_column_type(stmt, 1) == SQLITE_BLOB) != binary) {
+            const string text = encode(column(stmt, 1), binary);
+            sqlite3_bind_int64(update, 1, sqlite3_column_int64(stmt, 0));
+            bind(update, 2, text, binary);
+            step(update);
+            rows++;
+          }
+        sqlite3_finalize(stmt);
+        sqlite3_finalize(update);
+        exec("COMMIT;");
+        return rows;
+      };
+      static json column(sqlite3_stmt *const stmt, const int &col) {
+        const bool blob = sqlite3_column_type(stmt, col) == SQLITE_BLOB;
+        const char *const data = (const char*)sqlite3_column_blob(stmt, col);
+        return decode(data, sqlite3_column_bytes(stmt, col), blob);
+      };
+      static void bind(sqlite3_stmt *const stmt, const int &col, const string &text, const bool &blob) {
+        if (blob)
+          sqlite3_bind_blob(stmt, col, text.data(), text.length(), SQLITE_STATIC);
+        else sqlite3_bind_text(stmt, col, text.data(), text.length(), SQLITE_STATIC);
+      };
+      //! \brief Index the time of each row, also in tables created before.
+      void upgrade(Backup *const data) {
+        exec("CREATE INDEX IF NOT EXISTS " + schema(data) + "_time"
+          + " ON " + (char)data->about() + " (time);");
+      };
+      Statements prepare(Backup *const data) {
+        const string table = schema(data);
+        return {
+          data->limit() and !data->lifetime()
+            ? nullptr
+            : prepare("DELETE FROM " + table + (
+              data->limit()
+                ? " WHERE time < ?1"
+                : ""
+            ) + ";"),
+          prepare("DELETE FROM " + table + " WHERE id = ?1;"),
+          prepare("INSERT INTO " + table + " (id,json) VALUES(?1,?2);"),
+          prepare("SELECT COUNT(*), IFNULL(MAX(time), 0) FROM " + table + ";"),
+          table,
+          data
+        };
+      };
+      sqlite3_stmt *prepare(const string &sql, sqlite3 *const conn = nullptr) {
+        sqlite3_stmt *stmt = nullptr;
+        if (sqlite3_prepare_v3(conn ?: db, sql.data(), -1, SQLITE_PREPARE_PERSISTENT, &stmt, nullptr)) {
+          const string reason = "SQLite error: " + (sqlite3_errmsg(conn ?: db) + (" at " + sql));
+          if (conn) throw runtime_error(reason);
+          error("DB", reason);
+        }
+        return stmt;
+      };
+      void insert(Backup *const data, const Statements *const sql) {
+        const json   blob = data->blob();
+        const string incr = data->increment();
+        Row row = {
+          sql,
+          Tstamp,
+          Tstamp - data->lifetime(),
+          incr != "NULL",
+          incr != "NULL" ? stoll(incr) : 0,
+          binary,
+          blob.is_null() ? "" : encode(blob, binary),
+          nullptr
+        };
+        if (!writer.joinable()) upsert(row);
+        else enqueue(move(row));
+      };
+      void enqueue(Row &&row) {
+        while (!queue.push(move(row)))
+          if (overflow) {
+            dropped++;
+            return;
+          } else this_thread::yield();
+        awake();
+      };
+      //! \brief Queue the state of all tables, to be written by the writer
+      //!        after all the rows queued before it (so it matches the database).
+      void checkpoint() {
+        if (snapfile.empty() or restoring or !writer.joinable()) return;
+        frozen = Tstamp;
+        Row row;
+        row.time = frozen;
+        row.state = json::object();
+        for (const Statements &it : statements)
+          row.state[it.table] = it.data->snapshot();
+        enqueue(move(row));
+      };
+      void freeze(const json &state) {
+        json warm = json::object();
+        for (const Statements &it : statements)
+          if (state.find(it.table) != state.end())
+            warm[it.table] = {
+              {"fingerprint", fingerprint(it)    },
+              {       "rows", state.at(it.table) }
+            };
+        string data = magic;
+        json::to_msgpack({
+          {"version", version},
+          { "tables", warm   }
+        }, data);
+        ofstream file(snapfile + ".tmp", ios::binary | ios::trunc);
+        file.write(data.data(), data.length());
+        file.close();
+        if (file) rename((snapfile + ".tmp").data(), snapfile.data());
+      };
+      json thaw() const {
+        json warm = json::object();
+#ifndef _WIN32
+        if (snapfile.empty()) return warm;
+        const int fd = ::open(snapfile.data(), O_RDONLY | O_CLOEXEC);
+        if (fd < 0) return warm;
+        struct stat st;
+        if (!fstat(fd, &st) and (size_t)st.st_size > magic.length()) {
+          void *const data = mmap(nullptr, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+          if (data != MAP_FAILED) {
+            const char *const bytes = (const char*)data;
+            if (!magic.compare(0, magic.length(), bytes, magic.length())) {
+              const json j = json::from_msgpack(bytes + magic.length(), bytes + st.st_size, true, false);
+              if (j.is_object() and j.value("version", 0u) == version)
+                warm = j.value("tables", warm);
+            }
+            munmap(data, st.st_size);
+          }
+        }
+        ::close(fd);
+#endif
+        return warm;
+      };
+      json fingerprint(const Statements &sql) {
+        json j = json::array();
+        if (sqlite3_step(sql.fingerprint) == SQLITE_ROW)
+          j = {
+            sqlite3_column_int64(sql.fingerprint, 0),
+            sqlite3_column_int64(sql.fingerprint, 1)
+          };
+        sqlite3_reset(sql.fingerprint);
+        return j;
+      };
+      void awake() {
+        if (sleeping) {
+          lock_guard<mutex> lock(sleep);
+          wakeup.notify_one();
+        }
+      };
+      void drain() {
+        for (Row row;;)
+          if (queue.pop(row)) {
+            const Clock time = row.time;
+            const Metrics::Stopwatch batch(metrics.sqlite);
+            exec("BEGIN;");
+            do if (row.sql) upsert(row);
+               else freeze(row.state);
+            while (queue.pop(row));
+            exec("COMMIT;");
+            lag = Tstamp - time;
+          } else if (stopped) {
+            if (!queue.size()) break;
+          } else {
+            unique_lock<mutex> lock(sleep);
+            sleeping = true;
+            if (!queue.size() and !stopped)
+              wakeup.wait_for(lock, chrono::seconds(1));
+            sleeping = false;
+          }
+      };
+      void upsert(const Row &row) {
+        if (row.id) {
+          sqlite3_bind_int64(row.sql->erase_id, 1, row.incr);
+          step(row.sql->erase_id);
+        } else if (row.sql->erase) {
+          if (sqlite3_bind_parameter_count(row.sql->erase))
+            sqlite3_bind_int64(row.sql->erase, 1, row.cut);
+          step(row.sql->erase);
+        }
+        if (!row.text.empty()) {
+          if (row.id)
+            sqlite3_bind_int64(row.sql->insert, 1, row.incr);
+          bind(row.sql->insert, 2, row.text, row.binary);
+          step(row.sql->insert);
+        }
       };
       string schema(Backup *const data) const {
         return (
@@ -883,17 +1290,18 @@ namespace ₿ {
           ? "DELETE FROM " + table + " WHERE time < " + to_string(Tstamp - lifetime) + ";"
           : "";
       };
-      void exec(const string &sql, json *const result = nullptr) {
+      void step(sqlite3_stmt *const stmt) {
+        if (sqlite3_step(stmt) != SQLITE_DONE)
+          error("DB", "SQLite error: " + (sqlite3_errmsg(db) + (" at " + string(sqlite3_sql(stmt)))));
+        sqlite3_reset(stmt);
+        sqlite3_clear_bindings(stmt);
+      };
+      void exec(const string &sql) {
         char* zErrMsg = nullptr;
-        sqlite3_exec(db, sql.data(), result ? write : nullptr, (void*)result, &zErrMsg);
+        sqlite3_exec(db, sql.data(), nullptr, nullptr, &zErrMsg);
         if (zErrMsg) error("DB", "SQLite error: " + (zErrMsg + (" at " + sql)));
         sqlite3_free(zErrMsg);
       };
-      static int write(void *result, int argc, char **argv, char**) {
-        for (int i = 0; i < argc; ++i)
-          ((json*)result)->push_back(json::parse(argv[i]));
-        return 0;
-      };
   };
 
   class Client {
@@ -909,9 +1317,20 @@ namespace ₿ {
           virtual json hello() {
             return { blob() };
           };
+          //! \brief     Reply to a snapshot request that carries some payload.
+          //! \param[in] j Payload sent by the UI, like a cursor of older rows.
+          //! \return    Rows to send only to the asking UI, or null to ignore.
+          virtual json page(const json&) {
+            return nullptr;
+          };
           virtual bool realtime() const {
             return true;
           };
+          //! \return True if blob() holds the whole state of the matter,
+          //!         so a newer message may replace an unsent older one.
+          virtual bool snapshot() const {
+            return !realtime();
+          };
       };
       template <typename T> class Broadcast: public Readable {
         public:
@@ -920,7 +1339,7 @@ namespace ₿ {
           {};
           bool broadcast() {
             if ((read_asap() or read_soon())
-              and (read_same_blob() or diff_blob())
+              and diff_version()
             ) {
               if (read) read();
               return true;
@@ -931,14 +1350,22 @@ namespace ₿ {
             return *(T*)this;
           };
         protected:
-          Clock last_Tstamp = 0;
-          string last_blob;
-          virtual bool read_same_blob() const {
-            return true;
+           Clock last_Tstamp  = 0;
+          size_t last_version = 0;
+          //! \brief  Identify the state of blob() without serializing it.
+          //! \return Anything that changes together with blob(),
+          //!         or 0 to read again even if blob() did not change.
+          virtual size_t version() const {
+            return 0;
+          };
+          template <typename... Args> static size_t versions(const Args&... fields) {
+            size_t seed = 0;
+            ((seed ^= hash<Args>()(fields) + 0x9e3779b9 + (seed << 6) + (seed >> 2)), ...);
+            return seed ?: 1;
           };
-          bool diff_blob() {
-            const string last = last_blob;
-            return (last_blob = blob().dump()) != last;
+          bool diff_version() {
+            const size_t last = last_version;
+            return !(last_version = version()) or last_version != last;
           };
           virtual bool read_asap() const {
             return true;
@@ -987,14 +1414,62 @@ namespace ₿ {
       mutable vector<Clickable*> clickable;
       mutable unordered_map<const Clickable*, vector<function<void(const json&)>>> clickFn;
       const pair<char, char> portal = {'=', '-'};
-      unordered_map<char, function<json()>> hello;
+      unordered_map<char, function<json(const json&)>> hello;
       unordered_map<char, function<void(const json&)>> kisses;
-      unordered_map<char, string> queue;
+      vector<WebServer::Update> queue;
+      unordered_map<string, WebServer::Document> responses;
+      //! \brief Message of a UI client, or line to log, sent from the UI thread.
+      struct Letter {
+        size_t client = 0;
+        string text,
+               addr;
+          bool binary = false;
+      };
+      //! \brief Reply to a UI client, or messages to broadcast, sent from the engine.
+      struct Parcel {
+                           size_t client = 0;
+                           string reply;
+        vector<WebServer::Update> queue;
+      };
+      unique_ptr<Events> ui;
+                  thread serving;
+         Channel<Letter> inbox;
+         Channel<Parcel> outbox;
+           deque<Parcel> unsent;
+             Loop::Async *delivered = nullptr,
+                         *posted    = nullptr;
+            atomic<bool> closing    = {false};
+             atomic<int> connected  = {0};
     public:
-      void listen(const Option *const K, const curl_socket_t &loopfd) {
+      void listen(const Option *const K, Loop *const loop) {
         option = K;
+        for (const auto &it : documents) {
+          const string leaf = it.first.substr(it.first.find_last_of('.') + 1);
+          responses[it.first] = server.document(
+            string(it.second.first, it.second.second),
+              leaf == "js"  ? "application/javascript; charset=UTF-8"
+            : leaf == "css" ? "text/css; charset=UTF-8"
+            : leaf == "ico" ? "image/x-icon"
+            : leaf == "mp3" ? "audio/mpeg"
+            :                 "text/html; charset=UTF-8"
+          );
+        }
+        if (K->arg<int>("ui-thread")) {
+          ui = make_unique<Events>(metrics.ui);
+          inbox.reserve(1024);
+          outbox.reserve(1024);
+          delivered = loop->async([&]() {
+            receive();
+          });
+          posted = ui->async([&]() {
+            deliver();
+          });
+          ui->timer_1s([&](const unsigned int&) {
+            server.timeouts();
+          });
+        }
         if (!server.listen(
-          loopfd,
+          ui ? ui->poll() : loop->poll(),
           K->arg<string>("interface"),
           K->arg<int>("port"),
           K->arg<int>("ipv6"),
@@ -1002,7 +1477,10 @@ namespace ₿ {
             K->arg<string>("B64auth"),
             response,
             upgrade,
-            message
+            message,
+            K->arg<int>("deflate"),
+            !K->arg<int>("no-takeover"),
+            (size_t)K->arg<int>("client-queue") << 20
           }
         )) error("UI", "Unable to listen at port number " + to_string(K->arg<int>("port"))
              + " (may be already in use by another program)");
@@ -1013,6 +1491,9 @@ namespace ₿ {
           )) K->logWar("UI", it);
         protocol  = server.protocol();
         K->log("UI", "ready at", location());
+        if (ui) serving = thread([&]() {
+          ui->walk();
+        });
       };
       string location() const {
         return option
@@ -1029,17 +1510,29 @@ namespace ₿ {
       void broadcast(const unsigned int &tick) {
         if (delay and !(tick % delay))
           broadcast();
-        server.timeouts();
+        else if (ui and post() and !delay)
+          broadcast();
+        if (!ui) server.timeouts();
       };
       void welcome() {
         for (auto &it : readable) {
           it->read = [this, it]() {
-            if (server.idle()) return;
-            queue[(char)it->about()] = it->blob().dump();
+            if (!connected) return;
+            const char matter = (char)it->about();
+            const auto last = it->snapshot()
+              ? find_if(queue.begin(), queue.end(), [&](const WebServer::Update &msg) {
+                  return msg.matter == matter;
+                })
+              : queue.end();
+            if (last == queue.end())
+              queue.push_back({matter, it->blob(), it->snapshot()});
+            else last->data = it->blob();
             if (it->realtime() or !delay) broadcast();
           };
-          hello[(char)it->about()] = [it]() {
-            return it->hello();
+          hello[(char)it->about()] = [it](const json &j) {
+            return j.is_null()
+              ? it->hello()
+              : it->page(j);
           };
         }
         readable.clear();
@@ -1057,6 +1550,11 @@ namespace ₿ {
         documents.clear();
       };
       void without_goodbye() {
+        if (serving.joinable() and serving.get_id() != this_thread::get_id()) {
+          closing = true;
+          posted->wakeup();
+          serving.join();
+        }
         server.purge();
       };
     private:
@@ -1064,82 +1562,145 @@ namespace ₿ {
         clickFn[data].push_back(fn);
       };
       void broadcast() {
-        if (queue.empty()) return;
-        if (!server.idle())
-          server.broadcast(portal.second, queue);
+        if (queue.empty() or (ui and !post())) return;
+        if (connected) {
+          if (!ui)
+            server.broadcast(portal.second, queue);
+          else {
+            Parcel parcel = {0, "", move(queue)};
+            if (!outbox.push(move(parcel))) {
+              queue = move(parcel.queue);
+              return;
+            }
+            posted->wakeup();
+          }
+        }
         queue.clear();
       };
+      //! \brief  Move to the outbox the replies that did not fit before, in order.
+      //! \return True if none is left behind.
+      bool post() {
+        bool sent = false;
+        while (!unsent.empty() and outbox.push(move(unsent.front()))) {
+          unsent.pop_front();
+          sent = true;
+        }
+        if (sent) posted->wakeup();
+        return unsent.empty();
+      };
+      //! \brief Run in the engine thread whatever the UI thread asked for.
+      void receive() {
+        Letter letter;
+        while (inbox.pop(letter))
+          if (!letter.client)
+            option->log("UI", letter.text, letter.addr);
+          else {
+            Parcel parcel = {letter.client, answer(letter.text, letter.binary), {}};
+            if (!parcel.reply.empty())
+              unsent.push_back(move(parcel));
+          }
+        post();
+      };
+      //! \brief Run in the UI thread whatever the engine asked for.
+      void deliver() {
+        Parcel parcel;
+        while (outbox.pop(parcel))
+          if (parcel.client)
+            server.reply(parcel.client, parcel.reply);
+          else server.broadcast(portal.second, parcel.queue);
+        if (closing) ui->end();
+      };
+      //! \brief Log now, or later from the engine thread if called by the UI thread.
+      void note(const string &reason, const string &addr) {
+        if (!ui or closing)
+          option->log("UI", reason, addr);
+        else if (inbox.push({0, reason, addr, false}))
+          delivered->wakeup();
+      };
       bool alien(const string &addr) {
         if (addr != "unknown"
           and !option->arg<string>("whitelist").empty()
           and option->arg<string>("whitelist").find(addr) == string::npos
         ) {
-          option->log("UI", "dropping gzip bomb on", addr);
+          note("dropping gzip bomb on", addr);
           return true;
         }
         return false;
       };
-      WebServer::Response response = [&](string path, const string &auth, const string &addr) {
+      WebServer::Response response = [&](string path, const string &auth, const string &addr, const string &etag, const bool &gzip) {
         if (alien(addr))
           path.clear();
         const bool papersplease = !(path.empty() or option->arg<string>("B64auth").empty());
-        string content,
-               type = "text/html; charset=UTF-8";
+        string content;
         unsigned int code = 200;
         const string leaf = path.substr(path.find_last_of('.') + 1);
         if (papersplease and auth.empty()) {
-          option->log("UI", "authorization attempt from", addr);
+          note("authorization attempt from", addr);
           code = 401;
         } else if (papersplease and auth != option->arg<string>("B64auth")) {
-          option->log("UI", "authorization failed from", addr);
+          note("authorization failed from", addr);
           code = 403;
         } else if (leaf != "/" or server.clients() < option->arg<int>("client-limit")) {
-          if (documents.find(path) == documents.end())
+          if (path == "/metrics")
+            return make_shared<const string>(server.document(metrics.exposition(), code,
+              "text/plain; version=0.0.4; charset=UTF-8"));
+          if (responses.find(path) == responses.end())
             path = path.substr(path.find_last_of("/", path.find_last_of("/") - 1));
-          if (documents.find(path) == documents.end())
+          if (responses.find(path) == responses.end())
             path = path.substr(path.find_last_of("/"));
-          if (documents.find(path) != documents.end()) {
-            content = string(documents.at(path).first,
-                             documents.at(path).second);
-            if (leaf == "/") option->log("UI", "authorization success from", addr);
-            else if (leaf == "js")  type = "application/javascript; charset=UTF-8";
-            else if (leaf == "css") type = "text/css; charset=UTF-8";
-            else if (leaf == "ico") type = "image/x-icon";
-            else if (leaf == "mp3") type = "audio/mpeg";
-          } else {
-            if (Random::int64() % 21)
-              code = 404, content = "Today, is a beautiful day.";
-            else // Humans! go to any random path to check your luck.
-              code = 418, content = "Today, is your lucky day!";
+          if (responses.find(path) != responses.end()) {
+            if (leaf == "/") note("authorization success from", addr);
+            return responses.at(path).variant(etag, gzip);
           }
+          if (Random::int64() % 21)
+            code = 404, content = "Today, is a beautiful day.";
+          else // Humans! go to any random path to check your luck.
+            code = 418, content = "Today, is your lucky day!";
         } else {
-          option->log("UI", "--client-limit=" + to_string(option->arg<int>("client-limit"))
+          note("--client-limit=" + to_string(option->arg<int>("client-limit"))
             + " reached by", addr);
           content = "Thank you! but our princess is already in this castle!"
                     "<br/>" "Refresh the page anytime to retry.";
         }
-        return server.document(content, code, type);
+        return make_shared<const string>(server.document(content, code, "text/html; charset=UTF-8"));
       };
       WebServer::Upgrade upgrade = [&](const int &sum, const string &addr) {
         const int tentative = server.clients() + sum;
-        option->log("UI", to_string(tentative) + " client" + string(tentative == 1 ? 0 : 1, 's')
+        note(to_string(tentative) + " client" + string(tentative == 1 ? 0 : 1, 's')
           + (sum > 0 ? "" : " remain") + " connected, last connection was from", addr);
         if (tentative > option->arg<int>("client-limit")) {
-          option->log("UI", "--client-limit=" + to_string(option->arg<int>("client-limit"))
+          note("--client-limit=" + to_string(option->arg<int>("client-limit"))
             + " reached by", addr);
           return 0;
         }
+        connected += sum;
         return sum;
       };
-      WebServer::Message message = [&](string msg, const string &addr) {
+      WebServer::Message message = [&](string msg, const string &addr, const bool &binary, const size_t &client) {
         if (alien(addr))
           return string(documents.at("").first, documents.at("").second);
+        if (!ui)
+          return answer(msg, binary);
+        if (inbox.push({client, move(msg), addr, binary}))
+          delivered->wakeup();
+        return string();
+      };
+      string answer(string msg, const bool &binary) {
         const char matter = msg.at(1);
         if (portal.first == msg.at(0)) {
           if (hello.find(matter) != hello.end()) {
-            const json reply = hello.at(matter)();
-            if (!reply.is_null())
-              return portal.first + (matter + reply.dump());
+            msg = msg.substr(2);
+            const json reply = hello.at(matter)(
+              json::accept(msg)
+                ? json::parse(msg)
+                : json()
+            );
+            if (!reply.is_null()) {
+              string data = {portal.first, matter};
+              if (binary) json::to_cbor(reply, data);
+              else data += reply.dump();
+              return data;
+            }
           }
         } else if (portal.second == msg.at(0) and kisses.find(matter) != kisses.end()) {
           msg = msg.substr(2);
@@ -1173,6 +1734,8 @@ namespace ₿ {
               and holds_alternative<function<void(const Order&)>>(get<Gw::DataEvent>(it))
             ) ev_order = true;
           Option::main(this, argc, argv, ev_order, databases, documents.empty());
+          if (databases)
+            migrations(this);
           setup();
         } {
           if (windowed())
@@ -1205,6 +1768,7 @@ namespace ₿ {
             if (!dustybot)
               gateway->purge(arg<int>("dustybot"));
             gateway->end();
+            without_goodbye();
             end();
           });
           handshake({
@@ -1221,19 +1785,19 @@ namespace ₿ {
               timer_1s(get<TimeEvent>(it));
           events.clear();
         } {
-          if (databases)
-            backups(this);
-          else blackhole();
+          if (databases) {
+            backups(this, this);
+            ending([&]() {
+              without_backlog();
+            });
+          } else blackhole();
         } {
           if (arg<int>("headless")) headless();
           else {
-            listen(this, poll());
+            listen(this, this);
             timer_1s([&](const unsigned int &tick) {
               broadcast(tick);
             });
-            ending([&]() {
-              without_goodbye();
-            });
             welcome();
           }
         } {
@@ -29,11 +29,11 @@ namespace ₿ {
         }
         return data;
       };
-      string unframe(string &data, string &pong, bool &drop) const {
+      string unframe(string &data, string &pong, bool &drop, bool *const deflated = nullptr) const {
         string msg;
         const size_t max = data.length();
         if (max > 1) {
-          const bool flat = (data[0] & 0x40) != 0x40,
+          const bool flat = (data[0] & 0x40) != 0x40 or deflated,
                      text = (data[0] & 0x80) == 0x80,
                      mask = (data[1] & 0x80) == 0x80;
           const size_t key = mask ? 4 : 0;
@@ -51,9 +51,10 @@ namespace ₿ {
                 for (size_t i = 0; i < len; i++)
                   data.at(pos + i) ^= data.at(pos - key + (i % key));
               const unsigned char opcode = data[0] & 0x0F;
-              if      (opcode == 0x01)
+              if      (opcode == 0x01) {
                 msg = data.substr(pos, len);
-              else if (opcode == 0x09)
+                if (deflated) *deflated = data[0] & 0x40;
+              } else if (opcode == 0x09)
                 pong += frame(data.substr(pos, len), 0x0A, !mask);
               else if (opcode != 0x0A)
                 drop = true;
@@ -119,6 +120,148 @@ namespace ₿ {
       };
   };
 
+  //! \brief Lock-free counters and histograms, updated from any thread
+  //!        without allocations and rendered in Prometheus text format.
+  class Metrics {
+    public_friend:
+      class Counter {
+        public:
+          const char *const name,
+                     *const help,
+                     *const labels;
+        private:
+          atomic<unsigned long long> value = {0};
+        public:
+          Counter(const char *n, const char *h, const char *l = "")
+            : name(n)
+            , help(h)
+            , labels(l)
+          {};
+          void add(const unsigned long long &n = 1) {
+            value.fetch_add(n, memory_order_relaxed);
+          };
+          unsigned long long count() const {
+            return value.load(memory_order_relaxed);
+          };
+      };
+      class Histogram {
+        public:
+          //! \brief Upper bounds of the buckets in microseconds.
+          static constexpr unsigned long long bounds[] = {
+                 10,      25,      50,
+                100,     250,     500,
+               1000,    2500,    5000,
+              10000,   25000,   50000,
+             100000,  250000,  500000,
+            1000000, 2500000, 5000000,
+           10000000
+          };
+          static constexpr const char *seconds[] = {
+            "0.00001", "0.000025", "0.00005",
+            "0.0001",  "0.00025",  "0.0005",
+            "0.001",   "0.0025",   "0.005",
+            "0.01",    "0.025",    "0.05",
+            "0.1",     "0.25",     "0.5",
+            "1",       "2.5",      "5",
+            "10"
+          };
+          const char *const name,
+                     *const help,
+                     *const labels;
+        private:
+          atomic<unsigned long long> buckets[size(bounds) + 1] = {},
+                                     sum                       = {0};
+        public:
+          Histogram(const char *n, const char *h, const char *l = "")
+            : name(n)
+            , help(h)
+            , labels(l)
+          {};
+          void observe(const unsigned long long &micros) {
+            buckets[lower_bound(begin(bounds), end(bounds), micros) - begin(bounds)]
+              .fetch_add(1, memory_order_relaxed);
+            sum.fetch_add(micros, memory_order_relaxed);
+          };
+          unsigned long long count(const size_t &bucket) const {
+            return buckets[bucket].load(memory_order_relaxed);
+          };
+          double total() const {
+            return sum.load(memory_order_relaxed) / 1e+6;
+          };
+      };
+      //! \brief Observe the time spent until the end of the scope.
+      class Stopwatch {
+        private:
+                               Histogram &histogram;
+          const chrono::steady_clock::time_point start = chrono::steady_clock::now();
+        public:
+          Stopwatch(Histogram &h)
+            : histogram(h)
+          {};
+          ~Stopwatch() {
+            histogram.observe(chrono::duration_cast<chrono::microseconds>(
+              chrono::steady_clock::now() - start
+            ).count());
+          };
+      };
+    public:
+      Histogram engine  = {"k_loop_seconds",          "Time spent in the callbacks of each event loop iteration",   "loop=\"engine\""},
+                ui      = {"k_loop_seconds",          "Time spent in the callbacks of each event loop iteration",   "loop=\"ui\""},
+                latency = {"k_order_latency_seconds", "Time until new orders were acknowledged by the exchange"},
+                quotes  = {"k_quotes_seconds",        "Time spent in each recalculation of quotes"},
+                sqlite  = {"k_sqlite_write_seconds",  "Time spent writing each batch of rows into SQLite"};
+        Counter ws      = {"k_gateway_messages_total", "Messages parsed from each socket of the gateway",            "socket=\"ws\""},
+                twin    = {"k_gateway_messages_total", "Messages parsed from each socket of the gateway",            "socket=\"twin\""},
+                fix     = {"k_gateway_messages_total", "Messages parsed from each socket of the gateway",            "socket=\"fix\""},
+                sent    = {"k_ui_sent_bytes_total",    "Bytes written to UI connections"};
+      string exposition() const {
+        string text;
+        const char *last = "";
+        for (const Counter *it : {&ws, &twin, &fix, &sent}) {
+          if (strcmp(last, it->name))
+            text += family(last = it->name, it->help, "counter");
+          text += it->name + labels(it->labels) + ' ' + to_string(it->count()) + '\n';
+        }
+        for (const Histogram *it : {&engine, &ui, &latency, &quotes, &sqlite}) {
+          if (strcmp(last, it->name))
+            text += family(last = it->name, it->help, "histogram");
+          const string prefix = *it->labels
+            ? string(it->labels) + ','
+            : "";
+          unsigned long long count = 0;
+          for (size_t i = 0; i <= size(Histogram::bounds); i++)
+            text += it->name + string("_bucket{") + prefix + "le=\""
+                  + (i < size(Histogram::bounds) ? Histogram::seconds[i] : "+Inf")
+                  + "\"} " + to_string(count += it->count(i)) + '\n';
+          text += it->name + string("_sum")   + labels(it->labels) + ' ' + to_string(it->total()) + '\n'
+                + it->name + string("_count") + labels(it->labels) + ' ' + to_string(count)       + '\n';
+        }
+#ifndef _WIN32
+        struct rusage ru;
+        if (!getrusage(RUSAGE_SELF, &ru))
+          text += family("k_memory_maxrss_bytes", "Maximum resident set size of the process", "gauge")
+                + "k_memory_maxrss_bytes " + to_string(ru.ru_maxrss
+#ifndef __APPLE__
+                    * 1024
+#endif
+                  ) + '\n';
+#endif
+        return text;
+      };
+    private:
+      static string family(const char *name, const char *help, const char *type) {
+        return "# HELP " + string(name) + ' ' + help + '\n'
+             + "# TYPE " + string(name) + ' ' + type + '\n';
+      };
+      static string labels(const char *list) {
+        return *list
+          ? '{' + string(list) + '}'
+          : "";
+      };
+  };
+
+  inline Metrics metrics;
+
   class Loop {
     public_friend:
       using TimeEvent = function<void(const unsigned int&)>;
@@ -253,6 +396,7 @@ namespace ₿ {
         protected:
           const int EPOLLIN  = UV_READABLE;
           const int EPOLLOUT = UV_WRITABLE;
+          const int EPOLLET  = 0;
         private:
           uv_poll_t event;
         public:
@@ -290,6 +434,8 @@ namespace ₿ {
             Timer timer;
       list<Async> events;
     public:
+      Events(Metrics::Histogram& = metrics.engine)
+      {};
       void timer_ticks_factor(const unsigned int &factor) const override {
         timer.ticks_factor(factor);
       };
@@ -363,7 +509,7 @@ namespace ₿ {
             if (timerfd_settime(sockfd, 0, &ts, nullptr) != -1)
               Poll::start(loopfd, [&]() {
                 uint64_t again = 0;
-                if (::read(sockfd, &again, 8) == 8)
+                if (sockfd and ::read(sockfd, &again, 8) == 8)
                   timer_1s();
               });
           };
@@ -390,10 +536,12 @@ namespace ₿ {
                Timer timer;
          list<Async> events;
          epoll_event ready[32] = {};
+      Metrics::Histogram &laps;
     public:
-      Events()
+      Events(Metrics::Histogram &l = metrics.engine)
         : sockfd(epoll_create1(EPOLL_CLOEXEC))
         , timer(sockfd)
+        , laps(l)
       {};
       void timer_ticks_factor(const unsigned int &factor) const override {
         timer.ticks_factor(factor);
@@ -409,12 +557,12 @@ namespace ₿ {
         return sockfd;
       };
       void walk() override {
-        while (sockfd)
-          for (
-            int i = epoll_wait(sockfd, ready, 32, -1);
-            i --> 0;
-            ((Poll*)ready[i].data.ptr)->ready()
-          );
+        while (sockfd) {
+          int i = epoll_wait(sockfd, ready, 32, -1);
+          const Metrics::Stopwatch lap(laps);
+          while (i --> 0)
+            ((Poll*)ready[i].data.ptr)->ready();
+        }
       };
       void end() override {
         timer.stop();
@@ -697,6 +845,20 @@ namespace ₿ {
       static string CRC32(const string &input) {
         return to_string(crc32(0, (const Bytef*)input.data(), input.length()));
       };
+      static string GZIP(const string &input) {
+        string output;
+        z_stream zs = {};
+        if (deflateInit2(&zs, Z_BEST_COMPRESSION, Z_DEFLATED, 15 | 16, 9, Z_DEFAULT_STRATEGY) == Z_OK) {
+          output.resize(deflateBound(&zs, input.length()));
+          zs.next_in   = (Bytef*)input.data();
+          zs.avail_in  = input.length();
+          zs.next_out  = (Bytef*)output.data();
+          zs.avail_out = output.length();
+          output.resize(::deflate(&zs, Z_FINISH) == Z_STREAM_END ? zs.total_out : 0);
+          deflateEnd(&zs);
+        }
+        return output;
+      };
       static string B64(const string &input) {
         BIO *bio, *b64;
         BUF_MEM *bufferPtr;
@@ -787,16 +949,135 @@ namespace ₿ {
 
   class WebServer {
     public_friend:
-      using Response = function<string(string, const string&, const string&)>;
+      //! \brief Full responses of a static document, built once and shared by every request.
+      struct Document {
+                          string etag;
+        shared_ptr<const string> identity,
+                                 gzip,
+                                 unmodified;
+        //! \return The cheapest response allowed by the request headers.
+        const shared_ptr<const string> &variant(const string &match, const bool &accept) const {
+          if (!match.empty() and (match == "*" or match.find(etag.substr(2)) != string::npos))
+            return unmodified;
+          return accept and gzip ? gzip : identity;
+        };
+      };
+      //! \brief Message of a matter to broadcast; only snapshots may replace
+      //!        an unsent message of the same matter, while incremental
+      //!        messages (like diffs or single trades) are all kept in order.
+      struct Update {
+        char matter   = 0;
+        json data;
+        bool snapshot = false;
+      };
+      using Response = function<shared_ptr<const string>(string, const string&, const string&, const string&, const bool&)>;
       using Upgrade  = function<int(const int&, const string&)>;
-      using Message  = function<string(string, const string&)>;
+      using Message  = function<string(string, const string&, const bool&, const size_t&)>;
     private_friend:
       struct Session {
           string auth;
-        Response response = nullptr;
-         Upgrade upgrade  = nullptr;
-         Message message  = nullptr;
+        Response response  = nullptr;
+         Upgrade upgrade   = nullptr;
+         Message message   = nullptr;
+             int deflate   = 0;
+            bool takeover  = true;
+          size_t highwater = 0;
+      };
+    public_friend:
+      //! \brief Compression contexts of permessage-deflate (RFC 7692),
+      //!        one for each direction of a single WebSocket.
+      class Deflate {
+        private:
+          z_stream deflater  = {},
+                   inflater  = {};
+              bool deflating = false,
+                   inflating = false,
+                   takeover  = true;
+               int bits      = 15;
+        public:
+          ~Deflate() {
+            end();
+          };
+          bool init(const int &level, const int &b, const bool &t) {
+            end();
+            bits      = b;
+            takeover  = t;
+            deflating = deflateInit2(&deflater, level, Z_DEFLATED, -bits, 8, Z_DEFAULT_STRATEGY) == Z_OK;
+            inflating = inflateInit2(&inflater, -15) == Z_OK;
+            if (!deflating or !inflating) end();
+            return deflating;
+          };
+          //! \brief  Accept an offer of permessage-deflate, if acceptable.
+          //! \return Header line of the accepted extension, or empty.
+          string negotiate(string ext, const int &level, bool t) {
+            end();
+            if (!level or ext.find("permessage-deflate") == string::npos) return "";
+            ext = ext.substr(ext.find("permessage-deflate"));
+            ext = ext.substr(0, ext.find(","));
+            t = t and ext.find("server_no_context_takeover") == string::npos;
+            int b = 15;
+            const size_t window = ext.find("server_max_window_bits=");
+            if (window != string::npos)
+              b = atoi(ext.substr(window + 23).data());
+            if (b < 9 or b > 15 or !init(level, b, t)) return "";
+            return "Sec-WebSocket-Extensions: permessage-deflate"
+              + string(t ? "" : "; server_no_context_takeover")
+              + (window == string::npos ? "" : "; server_max_window_bits=" + to_string(b))
+              + "\r\n";
+          };
+          bool ready() const {
+            return deflating;
+          };
+          //! \return True if the output only depends on the message,
+          //!         so the same frame can be sent to every stateless client.
+          bool stateless() const {
+            return deflating and !takeover and bits == 15;
+          };
+          string compress(const string &data) {
+            string out;
+            deflater.next_in  = (Bytef*)data.data();
+            deflater.avail_in = data.length();
+            do {
+              const size_t len = out.length();
+              out.resize(len + 16384);
+              deflater.next_out  = (Bytef*)&out[len];
+              deflater.avail_out = 16384;
+              ::deflate(&deflater, Z_SYNC_FLUSH);
+              out.resize(len + 16384 - deflater.avail_out);
+            } while (!deflater.avail_out);
+            if (out.length() >= 4 and !out.compare(out.length() - 4, 4, "\x00\x00\xFF\xFF", 4))
+              out.resize(out.length() - 4);
+            if (!takeover) deflateReset(&deflater);
+            return out;
+          };
+          bool decompress(string &data, const size_t &limit = 1 << 20) {
+            if (!inflating) return false;
+            data.append("\x00\x00\xFF\xFF", 4);
+            string out;
+            inflater.next_in  = (Bytef*)data.data();
+            inflater.avail_in = data.length();
+            do {
+              const size_t len = out.length();
+              out.resize(len + 16384);
+              inflater.next_out  = (Bytef*)&out[len];
+              inflater.avail_out = 16384;
+              const int err = ::inflate(&inflater, Z_SYNC_FLUSH);
+              out.resize(len + 16384 - inflater.avail_out);
+              if ((err != Z_OK and err != Z_BUF_ERROR) or out.length() > limit)
+                return false;
+            } while (!inflater.avail_out);
+            data = move(out);
+            return true;
+          };
+        private:
+          void end() {
+            if (deflating) deflateEnd(&deflater);
+            if (inflating) inflateEnd(&inflater);
+            deflating =
+            inflating = false;
+          };
       };
+    private_friend:
       class Socket: public Events::Poll {
         public:
           Socket(const curl_socket_t &s = 0)
@@ -819,109 +1100,236 @@ namespace ₿ {
         private:
                     SSL *ssl     = nullptr;
           const Session *session = nullptr;
+           const size_t  serial  = 0;
                   Clock  time    = 0;
                  string  addr,
-                         out,
+                         head,
                          in;
+          deque<shared_ptr<const string>> out;
+          vector<pair<char, shared_ptr<const string>>> pending;
+          deque<pair<uint32_t, shared_ptr<const string>>> pinned;
+                 size_t  sent       = 0,
+                         chunk      = 4096;
+               uint32_t  zerocopies = 0;
+                   bool  zerocopy   = false;
+          curl_socket_t  lingering  = 0;
+                Deflate  deflate;
+                   bool  binary     = false,
+                         keepalive  = true;
         public:
-          Frontend(const curl_socket_t &s, const curl_socket_t &loopfd, SSL *S, const Session *e)
+          Frontend(const curl_socket_t &s, const curl_socket_t &loopfd, SSL *S, const Session *e, const size_t &n)
             : Socket(s)
             , ssl(S)
             , session(e)
+            , serial(n)
             , time(Tstamp)
           {
             Socket::start(loopfd, ioHttp);
+            change(EPOLLIN | EPOLLET);
+#ifdef SO_ZEROCOPY
+            const int enable = 1;
+            zerocopy = !ssl
+              and !setsockopt(sockfd, SOL_SOCKET, SO_ZEROCOPY, &enable, sizeof(enable));
+#endif
+          };
+          ~Frontend() {
+#ifdef SO_EE_ORIGIN_ZEROCOPY
+            if (lingering) ::close(lingering);
+#endif
           };
           void shutdown() {
+            if (!sockfd) return;
             if (ssl) {
               SSL_shutdown(ssl);
               SSL_free(ssl);
+              ssl = nullptr;
+            }
+#ifdef SO_EE_ORIGIN_ZEROCOPY
+            released(sockfd);
+            if (!pinned.empty()) {
+              ::shutdown(sockfd, SHUT_RDWR);
+              lingering = max(0, ::dup(sockfd));
             }
+#endif
+            pending.clear();
             Socket::shutdown();
             if (!time) session->upgrade(-1, addr);
           };
           bool upgraded() const {
-            return !time;
+            return !time and sockfd;
+          };
+          size_t id() const {
+            return serial;
+          };
+          //! \brief Queue a frame that may be shared with other clients,
+          //!        it is never copied nor modified until written.
+          void send(const shared_ptr<const string> &frame) {
+            if (frame->empty()) return;
+            out.push_back(frame);
+            change(EPOLLIN | EPOLLOUT | EPOLLET);
+          };
+          void send(string &&data) {
+            send(make_shared<const string>(move(data)));
+          };
+          //! \brief Keep only the latest snapshot of each matter while the socket is busy,
+          //!        and drop this client once its backlog is over the high-water mark.
+          //! \param[in] msg Shared frame, or plain message if compressed by this client.
+          void send(const char &matter, const bool &snapshot, const shared_ptr<const string> &msg) {
+            if (!sockfd) return;
+            const auto it = snapshot
+              ? find_if(pending.begin(), pending.end(), [&](const auto &it) {
+                  return it.first == matter;
+                })
+              : pending.end();
+            if (it == pending.end())
+              pending.emplace_back(matter, msg);
+            else it->second = msg;
+            if (out.empty())
+              release();
+            else if (session->highwater and backlog() > session->highwater)
+              shutdown();
+          };
+          void reply(const string &data) {
+            if (data.empty()) return;
+            const int opcode = binary or data.substr(0, 2) == "PK" ? 0x02 : 0x01;
+            if (deflate.ready())
+              send(frame(deflate.compress(data), opcode | 0x40, false));
+            else send(frame(data, opcode, false));
           };
-          void send(const string &data) {
-            out += data;
-            change(EPOLLIN | EPOLLOUT);
+          //! \return True if this client asked for CBOR instead of JSON text.
+          bool cbor() const {
+            return binary;
+          };
+          bool deflating() const {
+            return deflate.ready();
+          };
+          bool stateless() const {
+            return deflate.stateless();
           };
           bool stale() {
             if (time and sockfd and Tstamp > time + 21e+3)
               shutdown();
-            return !sockfd;
+            return !sockfd and !linger();
           };
         protected:
           string unframe() {
-            bool drop = false;
-            const string msg = WebSocketFrames::unframe(in, out, drop);
+            string pong;
+            bool drop     = false,
+                 deflated = false;
+            string msg = WebSocketFrames::unframe(in, pong, drop, deflate.ready() ? &deflated : nullptr);
+            if (deflated and !deflate.decompress(msg)) {
+              msg.clear();
+              drop = true;
+            }
+            if (!pong.empty()) send(move(pong));
             if (drop) shutdown();
             return msg;
           };
         private:
           function<void()> ioWs = [&]() {
             io();
-            if (!sockfd or in.empty()) return;
-            const string msg = unframe();
-            if (msg.empty()) return;
-            const string reply = session->message(msg, addr);
-            if (reply.empty()) return;
-            out += frame(reply, reply.substr(0, 2) == "PK" ? 0x02 : 0x01, false);
-            change(EPOLLIN | EPOLLOUT);
+            for (size_t len = 0; sockfd and !in.empty() and len != in.length();) {
+              len = in.length();
+              const string msg = unframe();
+              if (msg.empty()) continue;
+              reply(session->message(msg, addr, binary, serial));
+            }
           };
+          //! \brief Answer every complete request in order, keeping the connection
+          //!        open for more requests until it is idle for too long.
           function<void()> ioHttp = [&]() {
             io();
-            if (sockfd
-              and out.empty()
-              and in.length() > 5
-              and in.substr(0, 5) == "GET /"
-              and in.find("\r\n\r\n") != string::npos
-            ) {
+            while (sockfd and time and out.size() < 64) {
+              const size_t end = in.find("\r\n\r\n");
+              if (end == string::npos) {
+                if (in.length() > 65536) shutdown();
+                return;
+              }
+              head = in.substr(0, end + 4);
+              in.erase(0, end + 4);
+              if (head.substr(0, 5) != "GET /") {
+                shutdown();
+                return;
+              }
+              time = Tstamp;
               if (addr.empty())
                 addr = address();
-              const string path   = in.substr(4, in.find(" HTTP/1.1") - 4);
-              const size_t papers = in.find("Authorization: Basic ");
-              string auth;
-              if (papers != string::npos) {
-                auth = in.substr(papers + 21);
-                auth = auth.substr(0, auth.find("\r\n"));
-              }
-              const size_t key = in.find("Sec-WebSocket-Key: ");
+              const string path       = head.substr(4, head.find(' ', 4) - 4),
+                           auth       = header("Authorization: Basic "),
+                           connection = Text::strL(header("Connection: "));
+              if (connection.find("close") != string::npos or (
+                head.find(" HTTP/1.0" "\r\n") != string::npos
+                and connection.find("keep-alive") == string::npos
+              )) keepalive = false;
+              const size_t key = head.find("Sec-WebSocket-Key: ");
               int allowed = 1;
               if (key == string::npos) {
-                out = session->response(path, auth, addr);
-                if (out.empty())
+                const shared_ptr<const string> response = session->response(
+                  path, auth, addr,
+                  header("If-None-Match: "),
+                  header("Accept-Encoding: ").find("gzip") != string::npos
+                );
+                if (!response or response->empty())
                   shutdown();
-                else change(EPOLLIN | EPOLLOUT);
+                else send(response);
+                if (!keepalive) return;
               } else if ((session->auth.empty() or auth == session->auth)
-                and in.find("\r\n" "Upgrade: websocket" "\r\n") != string::npos
-                and in.find("\r\n" "Connection: ")              != string::npos
-                and in.find(" Upgrade")                         != string::npos
-                and in.find("Sec-WebSocket-Version: 13" "\r\n") != string::npos
+                and head.find("\r\n" "Upgrade: websocket" "\r\n") != string::npos
+                and head.find("\r\n" "Connection: ")              != string::npos
+                and head.find(" Upgrade")                         != string::npos
+                and head.find("Sec-WebSocket-Version: 13" "\r\n") != string::npos
                 and (allowed = session->upgrade(allowed, addr))
               ) {
                 time = 0;
-                out = "HTTP/1.1 101 Switching Protocols"
+                send("HTTP/1.1 101 Switching Protocols"
                       "\r\n" "Connection: Upgrade"
                       "\r\n" "Upgrade: websocket"
                       "\r\n" "Sec-WebSocket-Version: 13"
                       "\r\n" "Sec-WebSocket-Accept: "
                                + Text::B64(Text::SHA1(
-                                 in.substr(key + 19, in.substr(key + 19).find("\r\n"))
+                                 head.substr(key + 19, head.substr(key + 19).find("\r\n"))
                                    + "258EAFA5-E914-47DA-95CA-C5AB0DC85B11",
                                  true
                                )) +
-                      "\r\n"
-                      "\r\n";
-                in.clear();
-                change(EPOLLIN | EPOLLOUT, ioWs);
+                      "\r\n" + extensions() + protocols() +
+                      "\r\n");
+                head.clear();
+                change(EPOLLIN | EPOLLOUT | EPOLLET, ioWs);
               } else {
                 if (!allowed) session->upgrade(allowed, addr);
                 shutdown();
               }
             }
           };
+          string header(const string &name) const {
+            const size_t found = head.find(name);
+            return found == string::npos
+              ? ""
+              : head.substr(found + name.length(), head.find("\r\n", found) - found - name.length());
+          };
+          //! \brief  Accept a permessage-deflate offer, if enabled and acceptable.
+          //! \return Header line of the accepted extension, or empty.
+          string extensions() {
+            const size_t offer = head.find("\r\n" "Sec-WebSocket-Extensions: ");
+            if (offer == string::npos) return "";
+            return deflate.negotiate(
+              head.substr(offer + 28, head.find("\r\n", offer + 28) - offer - 28),
+              session->deflate,
+              session->takeover
+            );
+          };
+          //! \brief  Accept the "cbor" subprotocol, if offered.
+          //! \return Header line of the accepted subprotocol, or empty.
+          string protocols() {
+            const size_t offer = head.find("\r\n" "Sec-WebSocket-Protocol: ");
+            if (offer == string::npos) return "";
+            string offered = head.substr(offer + 26, head.find("\r\n", offer + 26) - offer - 26);
+            offered.erase(remove(offered.begin(), offered.end(), ' '), offered.end());
+            binary = ("," + offered + ",").find(",cbor,") != string::npos;
+            return binary
+              ? "Sec-WebSocket-Protocol: cbor" "\r\n"
+              : "";
+          };
           string address() const {
             string addr;
             union {
@@ -943,56 +1351,178 @@ namespace ₿ {
             }
             return addr.empty() ? "unknown" : addr;
           };
+          //! \brief Drain the socket both ways until it would block,
+          //!        because readiness is only notified on edges,
+          //!        but read at most 256 KB per call and re-arm the
+          //!        socket, so a fast peer can not hold the loop nor grow
+          //!        the input buffer before its limits are checked.
           void io() {
+            released(sockfd);
+            while (!out.empty()) {
+              const bool corked = out.size() > 1;
+              if (corked) cork(1);
+              if (!flush()) return;
+              if (corked) cork(0);
+              if (!out.empty()) break;
+              if (time and !keepalive) {
+                shutdown();
+                return;
+              }
+              if (!release())
+                change(EPOLLIN | EPOLLET);
+            }
+            for (size_t budget = 262144;;) {
+              const size_t len = in.length();
+              in.resize(len + chunk);
+              const ssize_t n = ssl
+                ? SSL_read(ssl, &in[len], chunk)
+                : ::recv(sockfd, &in[len], chunk, 0);
+              in.resize(len + max((ssize_t)0, n));
+              if (n > 0) {
+                if ((size_t)n == chunk and chunk < 262144) chunk *= 2;
+                else if ((size_t)n < chunk / 4 and chunk > 4096) chunk /= 2;
+                budget -= min(budget, (size_t)n);
+                if (budget or (ssl and SSL_pending(ssl))) continue;
+                change(EPOLLIN | EPOLLET | (out.empty() ? 0 : (int)EPOLLOUT));
+                return;
+              }
+              if (ssl) switch (SSL_get_error(ssl, n)) {
+                case SSL_ERROR_WANT_READ:
+                case SSL_ERROR_WANT_WRITE: return;
+                default:                   break;
+              } else if (n < 0 and errno == EINTR)
+                continue;
+              else if (n < 0 and (errno == EAGAIN or errno == EWOULDBLOCK))
+                return;
+              shutdown();
+              return;
+            }
+          };
+          //! \brief  Write as many queued frames as the socket takes, without joining them.
+          //! \return False if the socket was shutdown.
+          bool flush() {
             if (ssl) {
-              if (!out.empty()) {
-                cork(1);
-                int n = SSL_write(ssl, out.data(), out.length());
+              while (!out.empty()) {
+                const int n = SSL_write(ssl, out.front()->data() + sent, out.front()->length() - sent);
                 switch (SSL_get_error(ssl, n)) {
+                  case SSL_ERROR_NONE:        metrics.sent.add(n);
+                                              skip(n);
+                                              continue;
                   case SSL_ERROR_WANT_READ:
-                  case SSL_ERROR_WANT_WRITE:  break;
-                  case SSL_ERROR_NONE:        out.clear();
-                                              change(EPOLLIN);  [[fallthrough]];
-                  case SSL_ERROR_ZERO_RETURN: if (!time) break; [[fallthrough]];
+                  case SSL_ERROR_WANT_WRITE:  return true;
+                  case SSL_ERROR_ZERO_RETURN: if (!time) return true; [[fallthrough]];
                   default:                    shutdown();
-                                              return;
+                                              return false;
                 }
-                cork(0);
               }
-              do {
-                char data[1024];
-                int n = SSL_read(ssl, data, sizeof(data));
-                switch (SSL_get_error(ssl, n)) {
-                  case SSL_ERROR_NONE:        in.append(data, n);
-                  case SSL_ERROR_WANT_READ:
-                  case SSL_ERROR_WANT_WRITE:
-                  case SSL_ERROR_ZERO_RETURN: break;
-                  default:                    if (!time) break;
-                                              shutdown();
-                                              return;
-                }
-              } while (SSL_pending(ssl));
-            } else {
-              if (!out.empty()) {
-                cork(1);
-                ssize_t n = ::send(sockfd, out.data(), out.length(), MSG_NOSIGNAL);
-                if      (n > 0) out = out.substr(n);
-                else if (n < 0) {
-                  shutdown();
-                  return;
-                }
-                cork(0);
-                if (out.empty()) {
-                  if (time) {
-                    shutdown();
-                    return;
-                  }
-                  change(EPOLLIN);
-                }
+              return true;
+            }
+            while (!out.empty()) {
+              int flags = MSG_NOSIGNAL;
+#ifndef _WIN32
+              iovec iov[64];
+              size_t len = 0;
+#ifdef MSG_ZEROCOPY
+              const bool large = zerocopy
+                and out.front()->length() - sent >= 65536;
+              if (large) flags |= MSG_ZEROCOPY;
+#else
+              const bool large = false;
+#endif
+              for (auto it = out.begin(); it != out.end() and len < (large ? 1 : sizeof(iov) / sizeof(*iov)); ++it, ++len) {
+                if (len and zerocopy and (*it)->length() >= 65536) break;
+                iov[len].iov_base = (void*)((*it)->data() + (len ? 0 : sent));
+                iov[len].iov_len  = (*it)->length() - (len ? 0 : sent);
+              }
+              msghdr msg = {};
+              msg.msg_iov    = iov;
+              msg.msg_iovlen = len;
+              const ssize_t n = ::sendmsg(sockfd, &msg, flags);
+#else
+              const bool large = false;
+              const ssize_t n = ::send(sockfd, out.front()->data() + sent, out.front()->length() - sent, flags);
+#endif
+              if (n > 0) {
+                metrics.sent.add(n);
+                if (large) pinned.emplace_back(zerocopies++, out.front());
+                skip(n);
+              } else if (n < 0 and large and errno == ENOBUFS)
+                zerocopy = false;
+              else if (n < 0 and (errno == EAGAIN or errno == EWOULDBLOCK))
+                return true;
+              else if (n < 0 and errno == EINTR)
+                continue;
+              else {
+                shutdown();
+                return false;
+              }
+            }
+            return true;
+          };
+          //! \brief  Move the coalesced messages to the outgoing frames.
+          //! \return False if there was nothing pending.
+          bool release() {
+            if (pending.empty()) return false;
+            if (deflate.ready() and !deflate.stateless()) {
+              string frames;
+              for (const auto &it : pending)
+                frames += frame(deflate.compress(*it.second), (binary ? 0x02 : 0x01) | 0x40, false);
+              out.push_back(make_shared<const string>(move(frames)));
+            } else for (const auto &it : pending)
+              out.push_back(it.second);
+            pending.clear();
+            change(EPOLLIN | EPOLLOUT | EPOLLET);
+            return true;
+          };
+          size_t backlog() const {
+            size_t bytes = 0;
+            for (const auto &it : out)     bytes += it->length();
+            for (const auto &it : pending) bytes += it.second->length();
+            return bytes - sent;
+          };
+          //! \brief Forget frames sent with MSG_ZEROCOPY once the kernel is done with them.
+          void released(const curl_socket_t &fd) {
+#ifdef SO_EE_ORIGIN_ZEROCOPY
+            while (!pinned.empty()) {
+              char control[128];
+              msghdr msg = {};
+              msg.msg_control    = control;
+              msg.msg_controllen = sizeof(control);
+              if (::recvmsg(fd, &msg, MSG_ERRQUEUE) < 0) return;
+              for (cmsghdr *cm = CMSG_FIRSTHDR(&msg); cm; cm = CMSG_NXTHDR(&msg, cm)) {
+                const sock_extended_err *err = (const sock_extended_err*)CMSG_DATA(cm);
+                if (err->ee_origin != SO_EE_ORIGIN_ZEROCOPY) continue;
+                pinned.erase(remove_if(pinned.begin(), pinned.end(), [&](auto &it) {
+                  return it.first - err->ee_info <= err->ee_data - err->ee_info;
+                }), pinned.end());
+              }
+            }
+#endif
+          };
+          //! \return True while the kernel may still read frames sent with
+          //!         MSG_ZEROCOPY, so they outlive the shutdown of this socket.
+          bool linger() {
+#ifdef SO_EE_ORIGIN_ZEROCOPY
+            if (lingering) {
+              released(lingering);
+              if (pinned.empty()) {
+                ::close(lingering);
+                lingering = 0;
+              }
+            }
+#endif
+            return lingering;
+          };
+          void skip(size_t n) {
+            while (n) {
+              const size_t left = out.front()->length() - sent;
+              if (n < left) {
+                sent += n;
+                return;
               }
-              char data[1024];
-              ssize_t n = ::recv(sockfd, data, sizeof(data), 0);
-              if (n > 0) in.append(data, n);
+              n -= left;
+              sent = 0;
+              out.pop_front();
             }
           };
       };
@@ -1003,6 +1533,8 @@ namespace ₿ {
                  SSL_CTX *ctx = nullptr;
                  Session  session;
           list<Frontend>  requests;
+                 Deflate  stateless;
+                  size_t  serials = 0;
         public:
           bool idle() const {
             return !any_of(requests.begin(), requests.end(), [](auto &it) {
@@ -1017,13 +1549,45 @@ namespace ₿ {
           string protocol() const {
             return "HTTP" + string(ctx ? 1 : 0, 'S');
           };
-          void broadcast(const char &portal, const unordered_map<char, string> &queue) {
-            string msgs;
-            for (const auto &it : queue)
-              msgs += frame(portal + (it.first + it.second), 0x01, false);
+          //! \brief Serialize each message once per protocol and compress it once
+          //!        per stateless context, sharing the resulting frames by matter.
+          void broadcast(const char &portal, const vector<Update> &queue) {
+            vector<shared_ptr<const string>> msgs[2],
+                                             frames[2][2];
+            for (auto &it : requests) {
+              if (!it.upgraded()) continue;
+              const bool binary   = it.cbor(),
+                         deflated = it.deflating();
+              vector<shared_ptr<const string>> &texts = msgs[binary];
+              if (texts.empty())
+                for (const Update &msg : queue) {
+                  string text = {portal, msg.matter};
+                  if (binary) json::to_cbor(msg.data, text);
+                  else text += msg.data.dump();
+                  texts.push_back(make_shared<const string>(move(text)));
+                }
+              if (deflated and !it.stateless()) {
+                for (size_t i = 0; i < queue.size(); i++)
+                  it.send(queue[i].matter, queue[i].snapshot, texts[i]);
+                continue;
+              }
+              vector<shared_ptr<const string>> &shared = frames[binary][deflated];
+              if (shared.empty())
+                for (const auto &msg : texts)
+                  shared.push_back(make_shared<const string>(deflated
+                    ? frame(stateless.compress(*msg), (binary ? 0x02 : 0x01) | 0x40, false)
+                    : frame(*msg, binary ? 0x02 : 0x01, false)));
+              for (size_t i = 0; i < queue.size(); i++)
+                it.send(queue[i].matter, queue[i].snapshot, shared[i]);
+            }
+          };
+          //! \brief Answer a message of a client later, unless it is already gone.
+          void reply(const size_t &client, const string &data) {
             for (auto &it : requests)
-              if (it.upgraded())
-                it.send(msgs);
+              if (it.id() == client) {
+                if (it.upgraded()) it.reply(data);
+                return;
+              }
           };
           void purge() {
             if (!requests.empty()) {
@@ -1067,6 +1631,8 @@ namespace ₿ {
                   shutdown();
                 else {
                   session = data;
+                  if (session.deflate)
+                    stateless.init(session.deflate, 15, false);
                   start(loopfd, [this, loopfd]() {
                     accept_request(loopfd);
                   });
@@ -1138,13 +1704,31 @@ namespace ₿ {
             }
             return warn;
           };
-          string document(const string &content, const unsigned int &code, const string &type) const {
+          //! \brief Build every response of a static document ahead of any request,
+          //!        with a gzip variant only if it is smaller than the original.
+          Document document(const string &content, const string &type) const {
+            Document doc;
+            doc.etag       = "W/\"" + Text::CRC32(content) + "\"";
+            doc.identity   = make_shared<const string>(document(content, 200, type, doc.etag));
+            doc.unmodified = make_shared<const string>(document("", 304, type, doc.etag));
+            if (!gzipped(content)) {
+              const string gzip = Text::GZIP(content);
+              if (!gzip.empty() and gzip.length() < content.length())
+                doc.gzip = make_shared<const string>(document(gzip, 200, type, doc.etag));
+            }
+            return doc;
+          };
+          string document(const string &content, const unsigned int &code, const string &type, const string &etag = "") const {
             string headers;
             if      (code == 200) headers = "HTTP/1.1 200 OK"
                                             "\r\n" "Connection: keep-alive"
                                             "\r\n" "Accept-Ranges: bytes"
                                             "\r\n" "Vary: Accept-Encoding"
                                             "\r\n" "Cache-Control: public, max-age=0";
+            else if (code == 304) headers = "HTTP/1.1 304 Not Modified"
+                                            "\r\n" "Connection: keep-alive"
+                                            "\r\n" "Vary: Accept-Encoding"
+                                            "\r\n" "Cache-Control: public, max-age=0";
             else if (code == 401) headers = "HTTP/1.1 401 Unauthorized"
                                             "\r\n" "Connection: keep-alive"
                                             "\r\n" "Accept-Ranges: bytes"
@@ -1156,10 +1740,13 @@ namespace ₿ {
                                             "\r\n" "Vary: Accept-Encoding";
             else if (code == 418) headers = "HTTP/1.1 418 I'm a teapot";
             else                  headers = "HTTP/1.1 404 Not Found";
+            if (!etag.empty())
+              headers += "\r\n" "ETag: " + etag;
+            if (code == 304)
+              return headers + "\r\n"
+                               "\r\n";
             return headers
-                 + string((content.length() > 2 and (content.substr(0, 2) == "PK" or (
-                     content.at(0) == '\x1F' and content.at(1) == '\x8B'
-                 ))) ? "\r\n" "Content-Encoding: gzip" : "")
+                 + string(gzipped(content) ? "\r\n" "Content-Encoding: gzip" : "")
                  + "\r\n" "Content-Type: "   + type
                  + "\r\n" "Content-Length: " + to_string(content.length())
                  + "\r\n"
@@ -1167,6 +1754,11 @@ namespace ₿ {
                  + content;
           };
         private:
+          static bool gzipped(const string &content) {
+            return content.length() > 2 and (content.substr(0, 2) == "PK" or (
+              content.at(0) == '\x1F' and content.at(1) == '\x8B'
+            ));
+          };
           void accept_request(const curl_socket_t &loopfd) {
             curl_socket_t clientfd = accept4(sockfd, nullptr, nullptr, SOCK_CLOEXEC | SOCK_NONBLOCK);
             if (clientfd == -1) return;
@@ -1181,7 +1773,7 @@ namespace ₿ {
               SSL_set_fd(ssl, clientfd);
               SSL_set_mode(ssl, SSL_MODE_RELEASE_BUFFERS);
             }
-            requests.emplace_back(clientfd, loopfd, ssl, &session);
+            requests.emplace_back(clientfd, loopfd, ssl, &session, ++serials);
           };
           void socket(const int &domain, const int &type, const int &protocol) {
             sockfd = ::socket(domain, type | SOCK_CLOEXEC | SOCK_NONBLOCK, protocol);
@@ -1199,8 +1791,8 @@ namespace ₿ {
   class Random {
     public:
       static unsigned long long int64() {
-        static random_device rd;
-        static mt19937_64 gen(rd());
+        static thread_local random_device rd;
+        static thread_local mt19937_64 gen(rd());
         return uniform_int_distribution<unsigned long long>()(gen);
       };
       static string int45Id() {
@@ -1277,4 +1869,153 @@ namespace ₿ {
         return stream.str();
       };
   };
+
+  template <typename T> class Ring {
+    public:
+      template <bool Const> class Iterator {
+        friend class Iterator<!Const>;
+        public:
+          using iterator_category = random_access_iterator_tag;
+          using value_type        = T;
+          using difference_type   = ptrdiff_t;
+          using pointer           = conditional_t<Const, const T*, T*>;
+          using reference         = conditional_t<Const, const T&, T&>;
+        private:
+          conditional_t<Const, const Ring*, Ring*> ring = nullptr;
+          size_t index = 0;
+        public:
+          Iterator(decltype(ring) r, const size_t &i)
+            : ring(r)
+            , index(i)
+          {};
+          Iterator(const Iterator<false> &it)
+            : ring(it.ring)
+            , index(it.index)
+          {};
+          reference  operator*()                          const { return (*ring)[index];                  };
+          pointer    operator->()                         const { return &(*ring)[index];                 };
+          reference  operator[](const difference_type &n) const { return (*ring)[index + n];              };
+          Iterator  &operator++()                               { ++index; return *this;                  };
+          Iterator  &operator--()                               { --index; return *this;                  };
+          Iterator   operator++(int)                            { Iterator it = *this; ++index; return it; };
+          Iterator   operator--(int)                            { Iterator it = *this; --index; return it; };
+          Iterator  &operator+=(const difference_type &n)       { index += n; return *this;               };
+          Iterator  &operator-=(const difference_type &n)       { index -= n; return *this;               };
+          Iterator   operator+(const difference_type &n)  const { return {ring, index + n};               };
+          Iterator   operator-(const difference_type &n)  const { return {ring, index - n};               };
+          difference_type operator-(const Iterator &it)   const { return index - it.index;                };
+          bool       operator==(const Iterator &it)       const { return index == it.index;               };
+          bool       operator!=(const Iterator &it)       const { return index != it.index;               };
+          bool       operator<(const Iterator &it)        const { return index <  it.index;               };
+          bool       operator>(const Iterator &it)        const { return index >  it.index;               };
+          bool       operator<=(const Iterator &it)       const { return index <= it.index;               };
+          bool       operator>=(const Iterator &it)       const { return index >= it.index;               };
+      };
+      using value_type             = T;
+      using reference              = T&;
+      using const_reference        = const T&;
+      using iterator               = Iterator<false>;
+      using const_iterator         = Iterator<true>;
+      using reverse_iterator       = std::reverse_iterator<iterator>;
+      using const_reverse_iterator = std::reverse_iterator<const_iterator>;
+    private:
+      vector<T> buffer;
+         size_t head  = 0,
+                count = 0;
+    public:
+      iterator                 begin()       noexcept { return {this, 0};                        };
+      const_iterator           begin() const noexcept { return {this, 0};                        };
+      const_iterator          cbegin() const noexcept { return {this, 0};                        };
+      iterator                   end()       noexcept { return {this, count};                    };
+      const_iterator             end() const noexcept { return {this, count};                    };
+      const_iterator            cend() const noexcept { return {this, count};                    };
+      reverse_iterator        rbegin()       noexcept { return reverse_iterator(end());          };
+      const_reverse_iterator crbegin() const noexcept { return const_reverse_iterator(cend());   };
+      reverse_iterator          rend()       noexcept { return reverse_iterator(begin());        };
+      const_reverse_iterator   crend() const noexcept { return const_reverse_iterator(cbegin()); };
+      bool                     empty() const noexcept { return !count;                           };
+      size_t                    size() const noexcept { return count;                            };
+      size_t                capacity() const noexcept { return buffer.size();                    };
+      reference                front()                { return (*this)[0];                       };
+      const_reference          front() const          { return (*this)[0];                       };
+      reference                 back()                { return (*this)[count - 1];               };
+      const_reference           back() const          { return (*this)[count - 1];               };
+      reference           operator[](size_t n)        { return buffer[wrap(n)];                  };
+      const_reference     operator[](size_t n) const  { return buffer[wrap(n)];                  };
+      reference                   at(size_t n)        { return (*this)[check(n)];                };
+      const_reference             at(size_t n) const  { return (*this)[check(n)];                };
+      void reserve(const size_t &n) {
+        if (n <= capacity()) return;
+        vector<T> next(n);
+        for (size_t i = 0; i < count; ++i)
+          next[i] = move((*this)[i]);
+        buffer.swap(next);
+        head = 0;
+      };
+      void push_back(const T &row) {
+        if (count == capacity())
+          reserve(max((size_t)1, 2 * count));
+        buffer[wrap(count++)] = row;
+      };
+      iterator erase(const_iterator first, const_iterator last) {
+        const size_t from = first - cbegin(),
+                     n    = last  - first;
+        if (!from) head = count > n ? wrap(n) : 0;
+        else for (size_t i = from; i + n < count; ++i)
+          (*this)[i] = move((*this)[i + n]);
+        count -= n;
+        return begin() + from;
+      };
+      iterator erase(const_iterator it) {
+        return erase(it, it + 1);
+      };
+      void clear() noexcept {
+        head = count = 0;
+      };
+    private:
+      size_t wrap(const size_t &n) const {
+        const size_t i = head + n;
+        return i < capacity() ? i : i - capacity();
+      };
+      size_t check(const size_t &n) const {
+        if (n >= count) throw out_of_range("Ring::at");
+        return n;
+      };
+  };
+
+  //! \brief Bounded lock-free queue between exactly one producer thread
+  //!        and one consumer thread.
+  template <typename T> class Channel {
+    private:
+           vector<T> rows;
+      atomic<size_t> head = {0},
+                     tail = {0};
+    public:
+      void reserve(const size_t &depth) {
+        rows.resize(depth + 1);
+      };
+      //! \return False if full, leaving the row untouched.
+      bool push(T &&row) {
+        const size_t last = tail.load(memory_order_relaxed),
+                     next = (last + 1) % rows.size();
+        if (next == head.load(memory_order_acquire)) return false;
+        rows[last] = move(row);
+        tail.store(next, memory_order_release);
+        return true;
+      };
+      bool pop(T &row) {
+        const size_t first = head.load(memory_order_relaxed);
+        if (first == tail.load(memory_order_acquire)) return false;
+        row = move(rows[first]);
+        head.store((first + 1) % rows.size(), memory_order_release);
+        return true;
+      };
+      size_t size() const {
+        const size_t first = head.load(memory_order_acquire),
+                     last  = tail.load(memory_order_acquire);
+        return rows.empty()
+          ? 0
+          : (last + rows.size() - first) % rows.size();
+      };
+  };
 }
@@ -2,19 +2,26 @@
 //! \brief Available language interface.
 
 #include <cstdlib>
+#include <cerrno>
 #include <iostream>
 #include <iomanip>
 #include <fstream>
 #include <sstream>
 #include <string>
+#include <memory>
+#include <cstring>
 #include <vector>
 #include <unordered_map>
+#include <unordered_set>
 #include <map>
 #include <list>
+#include <deque>
 #include <ctime>
 #include <cmath>
 #include <mutex>
+#include <atomic>
 #include <thread>
+#include <condition_variable>
 #include <future>
 #include <chrono>
 #include <random>
@@ -35,6 +42,9 @@
 #include <execinfo.h>
 #include <sys/socket.h>
 #include <sys/resource.h>
+#include <sys/mman.h>
+#include <sys/uio.h>
+#include <fcntl.h>
 #include <arpa/inet.h>
 #include <netinet/in.h>
 #include <netinet/tcp.h>
@@ -47,6 +57,7 @@
 #include <sys/epoll.h>
 #include <sys/timerfd.h>
 #include <sys/eventfd.h>
+#include <linux/errqueue.h>
 #endif
 
 #include <zlib.h>
@@ -103,4 +103,304 @@ SCENARIO("general") {
       }
     }
   }
+  GIVEN("RateLimit") {
+    RateLimit limit;
+    WHEN("defaults") {
+      THEN("unlimited") {
+        REQUIRE(limit.ready());
+        REQUIRE_FALSE(limit.usage(60));
+      }
+    }
+    WHEN("assigned") {
+      REQUIRE_NOTHROW(limit.reset(1, 2));
+      THEN("burst") {
+        REQUIRE(limit.ready());
+        REQUIRE_NOTHROW(limit.spend());
+        REQUIRE(limit.ready());
+        REQUIRE_NOTHROW(limit.spend());
+        REQUIRE_FALSE(limit.ready());
+        REQUIRE_FALSE(limit.ready());
+        REQUIRE_FALSE(limit.throttled);
+        REQUIRE_NOTHROW(limit.defer());
+        REQUIRE(limit.spent == 2);
+        REQUIRE(limit.throttled == 1);
+        REQUIRE(limit.usage(60) == Approx(2.0 / 62));
+      }
+    }
+  }
+  GIVEN("Ring") {
+    Ring<double> ring;
+    WHEN("defaults") {
+      THEN("empty") {
+        REQUIRE(ring.empty());
+        REQUIRE_FALSE(ring.capacity());
+      }
+    }
+    WHEN("assigned") {
+      REQUIRE_NOTHROW(ring.reserve(4));
+      for (double it = 1; it <= 6; it++) {
+        REQUIRE_NOTHROW(ring.push_back(it));
+        if (ring.size() > 3)
+          REQUIRE_NOTHROW(ring.erase(ring.begin(), ring.end() - 3));
+      }
+      THEN("values") {
+        REQUIRE(ring.size() == 3);
+        REQUIRE(ring.capacity() == 4);
+        REQUIRE(ring.front() == 4);
+        REQUIRE(ring.back() == 6);
+        REQUIRE(ring.at(1) == 5);
+        REQUIRE(accumulate(ring.begin(), ring.end(), 0.0) == 15);
+        REQUIRE(*ring.crbegin() == 6);
+        REQUIRE_THROWS(ring.at(3));
+      }
+      WHEN("erase") {
+        REQUIRE_NOTHROW(ring.erase(ring.begin() + 1));
+        THEN("values") {
+          REQUIRE(ring.size() == 2);
+          REQUIRE(ring.front() == 4);
+          REQUIRE(ring.back() == 6);
+        }
+      }
+    }
+  }
+  GIVEN("Channel") {
+    Channel<string> channel;
+    string row;
+    WHEN("assigned") {
+      REQUIRE_NOTHROW(channel.reserve(2));
+      THEN("bounded") {
+        REQUIRE_FALSE(channel.pop(row));
+        REQUIRE(channel.push("a"));
+        REQUIRE(channel.push("b"));
+        row = "c";
+        REQUIRE_FALSE(channel.push(move(row)));
+        REQUIRE(row == "c");
+        REQUIRE(channel.size() == 2);
+        REQUIRE(channel.pop(row));
+        REQUIRE(row == "a");
+        REQUIRE(channel.push("c"));
+        REQUIRE(channel.pop(row));
+        REQUIRE(row == "b");
+        REQUIRE(channel.pop(row));
+        REQUIRE(row == "c");
+        REQUIRE_FALSE(channel.size());
+      }
+      THEN("threads") {
+        thread producer([&]() {
+          for (int i = 0; i < 10000; i++)
+            while (!channel.push(to_string(i)))
+              this_thread::yield();
+        });
+        int expected = 0,
+            unordered = 0;
+        while (expected < 10000)
+          if (!channel.pop(row))
+            this_thread::yield();
+          else if (row != to_string(expected++))
+            unordered++;
+        producer.join();
+        REQUIRE_FALSE(unordered);
+        REQUIRE_FALSE(channel.pop(row));
+      }
+    }
+  }
+  GIVEN("Sqlite") {
+    const json row = {
+      {"side", 1},
+      {"price", 1234.56},
+      {"quantity", 0.12345678},
+      {"time", 1600000000000},
+      {"tradeId", "1600000000000"},
+      {"value", 152.41},
+      {"Kqty", 0.1},
+      {"Kprice", 1240.01},
+      {"Kvalue", 124.001},
+      {"Kdiff", 0.54},
+      {"isPong", true}
+    };
+    string text, binary;
+    WHEN("encoded") {
+      REQUIRE_NOTHROW(text   = Sqlite::encode(row, false));
+      REQUIRE_NOTHROW(binary = Sqlite::encode(row, true));
+      THEN("decoded") {
+        REQUIRE(Sqlite::decode(text.data(), text.length(), false) == row);
+        REQUIRE(Sqlite::decode(binary.data(), binary.length(), true) == row);
+      }
+      THEN("smaller") {
+        REQUIRE(binary.length() < text.length());
+      }
+    }
+  }
+  GIVEN("WebServer") {
+    WebServer::Backend server;
+    WebServer::Document doc;
+    WHEN("document") {
+      REQUIRE_NOTHROW(doc = server.document(string(4096, 'K'), "text/css; charset=UTF-8"));
+      THEN("variants") {
+        REQUIRE(doc.identity->find("HTTP/1.1 200 OK") == 0);
+        REQUIRE(doc.identity->find("ETag: " + doc.etag + "\r\n") != string::npos);
+        REQUIRE(doc.identity->find("Content-Encoding: gzip") == string::npos);
+        REQUIRE(doc.gzip->find("Content-Encoding: gzip") != string::npos);
+        REQUIRE(doc.gzip->length() < doc.identity->length());
+        REQUIRE(doc.unmodified->find("HTTP/1.1 304 Not Modified") == 0);
+        REQUIRE(doc.unmodified->find("Content-Length") == string::npos);
+      }
+      THEN("conditional") {
+        REQUIRE(doc.variant("", false) == doc.identity);
+        REQUIRE(doc.variant("", true) == doc.gzip);
+        REQUIRE(doc.variant(doc.etag, true) == doc.unmodified);
+        REQUIRE(doc.variant(doc.etag.substr(2), false) == doc.unmodified);
+        REQUIRE(doc.variant("\"0\"", false) == doc.identity);
+      }
+    }
+    WHEN("gzipped") {
+      REQUIRE_NOTHROW(doc = server.document(Text::GZIP(string(4096, 'K')), "application/javascript; charset=UTF-8"));
+      THEN("as is") {
+        REQUIRE(doc.identity->find("Content-Encoding: gzip") != string::npos);
+        REQUIRE_FALSE(doc.gzip);
+        REQUIRE(doc.variant("", true) == doc.identity);
+      }
+    }
+  }
+  GIVEN("Deflate") {
+    WebServer::Deflate deflate;
+    const string msg = "{\"price\":1234.56,\"size\":0.12345678}";
+    string first, second;
+    WHEN("defaults") {
+      THEN("disabled") {
+        REQUIRE_FALSE(deflate.ready());
+        REQUIRE_FALSE(deflate.decompress(first));
+        REQUIRE(deflate.negotiate("permessage-deflate", 0, true).empty());
+      }
+    }
+    WHEN("negotiated") {
+      THEN("takeover") {
+        REQUIRE(deflate.negotiate("permessage-deflate; client_max_window_bits", 6, true)
+          == "Sec-WebSocket-Extensions: permessage-deflate\r\n");
+        REQUIRE(deflate.ready());
+        REQUIRE_FALSE(deflate.stateless());
+      }
+      THEN("no takeover") {
+        REQUIRE(deflate.negotiate("permessage-deflate; server_no_context_takeover", 6, true)
+          == "Sec-WebSocket-Extensions: permessage-deflate; server_no_context_takeover\r\n");
+        REQUIRE(deflate.stateless());
+        REQUIRE(deflate.negotiate("permessage-deflate", 6, false)
+          == "Sec-WebSocket-Extensions: permessage-deflate; server_no_context_takeover\r\n");
+      }
+      THEN("window bits") {
+        REQUIRE(deflate.negotiate("permessage-deflate; server_max_window_bits=10", 6, false)
+          == "Sec-WebSocket-Extensions: permessage-deflate; server_no_context_takeover; server_max_window_bits=10\r\n");
+        REQUIRE_FALSE(deflate.stateless());
+        REQUIRE(deflate.negotiate("permessage-deflate; server_max_window_bits=8", 6, true).empty());
+        REQUIRE_FALSE(deflate.ready());
+        REQUIRE(deflate.negotiate("permessage-deflate; server_max_window_bits=16", 6, true).empty());
+        REQUIRE_FALSE(deflate.ready());
+        REQUIRE(deflate.negotiate("x-webkit-deflate-frame", 6, true).empty());
+      }
+    }
+    WHEN("takeover") {
+      REQUIRE_FALSE(deflate.negotiate("permessage-deflate", 6, true).empty());
+      REQUIRE_NOTHROW(first  = deflate.compress(msg));
+      REQUIRE_NOTHROW(second = deflate.compress(msg));
+      THEN("without tail") {
+        REQUIRE(first.length() >= 4);
+        REQUIRE(first.compare(first.length() - 4, 4, "\x00\x00\xFF\xFF", 4));
+        REQUIRE(second.compare(second.length() - 4, 4, "\x00\x00\xFF\xFF", 4));
+      }
+      THEN("shared window") {
+        REQUIRE(second.length() < first.length());
+      }
+      THEN("round trip") {
+        REQUIRE(deflate.decompress(first));
+        REQUIRE(first == msg);
+        REQUIRE(deflate.decompress(second));
+        REQUIRE(second == msg);
+      }
+    }
+    WHEN("no takeover") {
+      REQUIRE_FALSE(deflate.negotiate("permessage-deflate", 6, false).empty());
+      REQUIRE_NOTHROW(first  = deflate.compress(msg));
+      REQUIRE_NOTHROW(second = deflate.compress(msg));
+      THEN("without tail") {
+        REQUIRE(first.compare(first.length() - 4, 4, "\x00\x00\xFF\xFF", 4));
+      }
+      THEN("same frame") {
+        REQUIRE(first == second);
+      }
+      THEN("round trip") {
+        REQUIRE(deflate.decompress(first));
+        REQUIRE(first == msg);
+        REQUIRE(deflate.decompress(second));
+        REQUIRE(second == msg);
+      }
+    }
+    WHEN("inflated") {
+      REQUIRE_FALSE(deflate.negotiate("permessage-deflate", 6, false).empty());
+      REQUIRE_NOTHROW(first  = deflate.compress(string(1 << 20, 'K')));
+      REQUIRE_NOTHROW(second = deflate.compress(string((1 << 20) + 1, 'K')));
+      THEN("limited") {
+        REQUIRE(deflate.decompress(first));
+        REQUIRE(first.length() == 1 << 20);
+        REQUIRE_FALSE(deflate.decompress(second));
+      }
+    }
+  }
+  GIVEN("Metrics") {
+    Metrics m;
+    WHEN("observed") {
+      m.quotes.observe(42);
+      m.ws.add();
+      m.ws.add();
+      { const Metrics::Stopwatch lap(m.sqlite); }
+      const string text = m.exposition();
+      THEN("exposition") {
+        REQUIRE(text.find("# TYPE k_quotes_seconds histogram\n") != string::npos);
+        REQUIRE(text.find("k_quotes_seconds_bucket{le=\"0.000025\"} 0\n") != string::npos);
+        REQUIRE(text.find("k_quotes_seconds_bucket{le=\"0.00005\"} 1\n") != string::npos);
+        REQUIRE(text.find("k_quotes_seconds_bucket{le=\"+Inf\"} 1\n") != string::npos);
+        REQUIRE(text.find("k_quotes_seconds_count 1\n") != string::npos);
+        REQUIRE(text.find("k_sqlite_write_seconds_count 1\n") != string::npos);
+        REQUIRE(text.find("k_loop_seconds_bucket{loop=\"ui\",le=\"+Inf\"} 0\n") != string::npos);
+        REQUIRE(text.find("k_gateway_messages_total{socket=\"ws\"} 2\n") != string::npos);
+        REQUIRE(text.find("k_gateway_messages_total{socket=\"fix\"} 0\n") != string::npos);
+      }
+    }
+  }
+}
+
+SCENARIO("benchmarks", "[!benchmark]") {
+  GIVEN("Sqlite rows") {
+    json rows = json::array();
+    for (int i = 0; i < 10000; i++)
+      rows.push_back({
+        {"price", 1234.56 + i},
+        {"quantity", 0.12345678},
+        {"time", 1600000000000 + i},
+        {"tradeId", to_string(1600000000000 + i)}
+      });
+    vector<string> text, binary;
+    size_t textSize = 0, binarySize = 0;
+    for (const json &it : rows) {
+      text.push_back(Sqlite::encode(it, false));
+      binary.push_back(Sqlite::encode(it, true));
+      textSize   += text.back().length();
+      binarySize += binary.back().length();
+    }
+    WARN("encoded size of " << rows.size() << " rows: "
+      << textSize << " bytes as JSON text, "
+      << binarySize << " bytes as MessagePack");
+    REQUIRE(binarySize < textSize);
+    BENCHMARK("decode JSON text") {
+      json loaded = json::array();
+      for (const string &it : text)
+        loaded.push_back(Sqlite::decode(it.data(), it.length(), false));
+      return loaded;
+    };
+    BENCHMARK("decode MessagePack") {
+      json loaded = json::array();
+      for (const string &it : binary)
+        loaded.push_back(Sqlite::decode(it.data(), it.length(), true));
+      return loaded;
+    };
+  }
 }
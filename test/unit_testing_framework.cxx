@@ -12,6 +12,8 @@
 //!            visualize and understand the execution order of test units.
 //! \note      While using --durations, the output should be read from top to bottom,
 //!            but the output inside each scenario should be read from bottom to top.
+//! \note      Benchmarks are hidden, to run them replace "--durations yes"
+//!            with "[!benchmark]" and uncomment the same 3 lines.
 [[noreturn]] void catch_exit(const int code) {
   // const char *argv[] = {"K", "--durations yes", nullptr};
   // const int argc = sizeof(argv) / sizeof(char*) - 1;